@@ -0,0 +1,247 @@
+/* Copyright (c) 2019 The Indirect Value Authors. All Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+==============================================================================*/
+
+// Asserts the exact number of allocations made by each indirect_value
+// operation. A change that adds an allocation to any of these paths must
+// update the expected counts here deliberately.
+
+#define ISOCPP_P1950_DEFINE_COUNTING_NEW_DELETE
+#include "allocation_counting.h"
+
+#include <memory>
+#include <optional>
+#include <utility>
+
+#include "catch2/catch_test_macros.hpp"
+#include "indirect_tuple.h"
+#include "indirect_value.h"
+
+using isocpp_p1950::allocate_indirect_value;
+using isocpp_p1950::indirect_tuple;
+using isocpp_p1950::indirect_value;
+using isocpp_p1950::make_indirect_value;
+using isocpp_p1950::try_make_indirect_value;
+using isocpp_p1950::testing::allocation_counts;
+using isocpp_p1950::testing::allocation_scope;
+using isocpp_p1950::testing::count_allocations;
+using isocpp_p1950::testing::counting_allocator;
+
+namespace {
+struct Payload {
+  int values[16] = {};
+};
+
+constexpr allocation_counts none{0, 0};
+constexpr allocation_counts one_allocation{1, 0};
+constexpr allocation_counts one_deallocation{0, 1};
+constexpr allocation_counts one_each{1, 1};
+}  // namespace
+
+TEST_CASE("The counting global operators are installed",
+          "[allocation_count.harness]") {
+  REQUIRE(isocpp_p1950::testing::counting_new_delete_installed());
+  // Calls the allocation functions directly: unlike a new-expression, such
+  // calls may not be elided by the optimiser.
+  const auto counts = count_allocations(
+      [] { ::operator delete(::operator new(sizeof(int))); });
+  REQUIRE(counts == one_each);
+}
+
+TEST_CASE("Allocations made by construction and destruction",
+          "[allocation_count.construct]") {
+  std::optional<indirect_value<Payload>> iv;
+
+  SECTION("Default construction") {
+    REQUIRE(count_allocations([&] { iv.emplace(); }) == none);
+    REQUIRE(count_allocations([&] { iv.reset(); }) == none);
+  }
+  SECTION("In-place construction") {
+    REQUIRE(count_allocations([&] { iv.emplace(std::in_place); }) ==
+            one_allocation);
+    REQUIRE(count_allocations([&] { iv.reset(); }) == one_deallocation);
+  }
+  SECTION("Construction from a pointer adopts it") {
+    auto* p = new Payload;
+    REQUIRE(count_allocations([&] { iv.emplace(p); }) == none);
+    REQUIRE(count_allocations([&] { iv.reset(); }) == one_deallocation);
+  }
+  SECTION("make_indirect_value") {
+    REQUIRE(count_allocations([&] {
+              iv.emplace(make_indirect_value<Payload>());
+            }) == one_allocation);
+  }
+  SECTION("try_make_indirect_value") {
+    REQUIRE(count_allocations([&] {
+              iv.emplace(try_make_indirect_value<Payload>());
+            }) == one_allocation);
+  }
+}
+
+TEST_CASE("Allocations made by copying and moving",
+          "[allocation_count.copy]") {
+  const auto engaged = make_indirect_value<Payload>();
+  const indirect_value<Payload> empty;
+  std::optional<indirect_value<Payload>> iv;
+
+  SECTION("Copy construction from an engaged value") {
+    REQUIRE(count_allocations([&] { iv.emplace(engaged); }) ==
+            one_allocation);
+  }
+  SECTION("Copy construction from an empty value") {
+    REQUIRE(count_allocations([&] { iv.emplace(empty); }) == none);
+  }
+  SECTION("Move construction") {
+    auto source = make_indirect_value<Payload>();
+    REQUIRE(count_allocations([&] { iv.emplace(std::move(source)); }) ==
+            none);
+  }
+}
+
+TEST_CASE("Allocations made by assignment and swap",
+          "[allocation_count.assign]") {
+  const auto engaged = make_indirect_value<Payload>();
+  auto target = make_indirect_value<Payload>();
+  indirect_value<Payload> empty_target;
+
+  SECTION("Copy assignment to an engaged value replaces its allocation") {
+    REQUIRE(count_allocations([&] { target = engaged; }) == one_each);
+  }
+  SECTION("Copy assignment to an empty value") {
+    REQUIRE(count_allocations([&] { empty_target = engaged; }) ==
+            one_allocation);
+  }
+  SECTION("Copy assignment from an empty value") {
+    REQUIRE(count_allocations([&] { target = indirect_value<Payload>(); }) ==
+            one_deallocation);
+  }
+  SECTION("Move assignment releases only the target's value") {
+    auto source = make_indirect_value<Payload>();
+    REQUIRE(count_allocations([&] { target = std::move(source); }) ==
+            one_deallocation);
+  }
+  SECTION("Move assignment to an empty value") {
+    auto source = make_indirect_value<Payload>();
+    REQUIRE(count_allocations([&] { empty_target = std::move(source); }) ==
+            none);
+  }
+  SECTION("Swap") {
+    REQUIRE(count_allocations([&] { swap(target, empty_target); }) == none);
+    REQUIRE(count_allocations([&] { target.swap(empty_target); }) == none);
+  }
+}
+
+TEST_CASE("Allocations made through an allocator",
+          "[allocation_count.allocator]") {
+  allocation_counts through_allocator;
+  counting_allocator<Payload> alloc(through_allocator);
+
+  SECTION("allocate_indirect_value allocates once through the allocator") {
+    const auto global = count_allocations([&] {
+      auto iv = allocate_indirect_value<Payload>(std::allocator_arg, alloc);
+      REQUIRE(through_allocator == one_allocation);
+    });
+    REQUIRE(through_allocator == one_each);
+    // counting_allocator obtains its memory from the global operator new.
+    REQUIRE(global == one_each);
+  }
+  SECTION("Copying an allocator-aware value uses the allocator") {
+    auto iv = allocate_indirect_value<Payload>(std::allocator_arg, alloc);
+    through_allocator = none;
+    {
+      auto copy = iv;
+      REQUIRE(through_allocator == one_allocation);
+      copy = iv;
+      REQUIRE(through_allocator == allocation_counts{2, 1});
+    }
+    REQUIRE(through_allocator == allocation_counts{2, 2});
+  }
+  SECTION("Moving an allocator-aware value does not allocate") {
+    auto iv = allocate_indirect_value<Payload>(std::allocator_arg, alloc);
+    through_allocator = none;
+    {
+      auto moved = std::move(iv);
+      REQUIRE(through_allocator == none);
+    }
+    REQUIRE(through_allocator == one_deallocation);
+  }
+}
+
+TEST_CASE("Allocations made by array indirect_values",
+          "[allocation_count.array]") {
+  std::optional<indirect_value<Payload[]>> iv;
+
+  SECTION("make_indirect_value allocates all elements at once") {
+    REQUIRE(count_allocations([&] {
+              iv.emplace(make_indirect_value<Payload[]>(8));
+            }) == one_allocation);
+    REQUIRE(count_allocations([&] { iv.reset(); }) == one_deallocation);
+  }
+  SECTION("Copying allocates once") {
+    const auto source = make_indirect_value<Payload[]>(8);
+    REQUIRE(count_allocations([&] { iv.emplace(source); }) ==
+            one_allocation);
+  }
+  SECTION("Moving does not allocate") {
+    auto source = make_indirect_value<Payload[]>(8);
+    REQUIRE(count_allocations([&] { iv.emplace(std::move(source)); }) ==
+            none);
+  }
+  SECTION("allocate_indirect_value allocates once through the allocator") {
+    allocation_counts through_allocator;
+    counting_allocator<Payload> alloc(through_allocator);
+    {
+      auto a =
+          allocate_indirect_value<Payload[]>(std::allocator_arg, alloc, 8);
+      REQUIRE(through_allocator == one_allocation);
+    }
+    REQUIRE(through_allocator == one_each);
+  }
+}
+
+TEST_CASE("Allocations made by indirect_tuple",
+          "[allocation_count.indirect_tuple]") {
+  using tuple = indirect_tuple<int, Payload, Payload>;
+
+  SECTION("Construction allocates every object at once") {
+    allocation_scope scope;
+    {
+      tuple t;
+      REQUIRE(scope.counts() == one_allocation);
+    }
+    REQUIRE(scope.counts() == one_each);
+  }
+  SECTION("Copying allocates once") {
+    const tuple source;
+    allocation_scope scope;
+    tuple copy = source;
+    REQUIRE(scope.counts() == one_allocation);
+  }
+  SECTION("Copy assignment allocates once and releases the old block") {
+    const tuple source;
+    tuple target;
+    REQUIRE(count_allocations([&] { target = source; }) == one_each);
+  }
+  SECTION("Moving does not allocate") {
+    tuple source;
+    allocation_scope scope;
+    tuple moved = std::move(source);
+    REQUIRE(scope.counts() == none);
+  }
+}
@@ -0,0 +1,290 @@
+/* Copyright (c) 2019 The Indirect Value Authors. All Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+==============================================================================*/
+
+#ifndef ISOCPP_P1950_ALLOCATION_COUNTING_H
+#define ISOCPP_P1950_ALLOCATION_COUNTING_H
+
+// Test support for asserting how many allocations an operation makes.
+//
+// allocation_scope observes the calls this thread makes to the global
+// operator new and operator delete while the scope is alive. The counts are
+// only maintained when the global operators are replaced by the counting
+// versions below: define ISOCPP_P1950_DEFINE_COUNTING_NEW_DELETE before
+// including this header in exactly one translation unit of the test program.
+//
+// counting_allocator counts the calls made through it independently of the
+// global operators, so it can check allocator-aware code paths.
+
+#include <cstddef>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <utility>
+
+#include "indirect_value.h"
+
+namespace isocpp_p1950::testing {
+
+struct allocation_counts {
+  std::size_t allocations = 0;
+  std::size_t deallocations = 0;
+
+  friend bool operator==(const allocation_counts& lhs,
+                         const allocation_counts& rhs) noexcept {
+    return lhs.allocations == rhs.allocations &&
+           lhs.deallocations == rhs.deallocations;
+  }
+
+  friend bool operator!=(const allocation_counts& lhs,
+                         const allocation_counts& rhs) noexcept {
+    return !(lhs == rhs);
+  }
+};
+
+namespace detail {
+
+// Counters are per thread so that tests are not disturbed by allocations on
+// other threads.
+inline allocation_counts& thread_allocation_counts() noexcept {
+  thread_local allocation_counts counts;
+  return counts;
+}
+
+inline bool& counting_new_delete_installed() noexcept {
+  static bool installed = false;
+  return installed;
+}
+
+}  // namespace detail
+
+// True if the counting global operator new and delete are linked in.
+inline bool counting_new_delete_installed() noexcept {
+  return detail::counting_new_delete_installed();
+}
+
+// Counts this thread's global allocations and deallocations from
+// construction onwards.
+class allocation_scope {
+ public:
+  allocation_scope() noexcept : start_(detail::thread_allocation_counts()) {}
+
+  allocation_counts counts() const noexcept {
+    const allocation_counts& now = detail::thread_allocation_counts();
+    return {now.allocations - start_.allocations,
+            now.deallocations - start_.deallocations};
+  }
+
+  std::size_t allocations() const noexcept { return counts().allocations; }
+
+  std::size_t deallocations() const noexcept { return counts().deallocations; }
+
+ private:
+  allocation_counts start_;
+};
+
+// Runs f() and returns the global allocations and deallocations it made on
+// this thread.
+template <class F>
+allocation_counts count_allocations(F&& f) {
+  allocation_scope scope;
+  std::forward<F>(f)();
+  return scope.counts();
+}
+
+// A std::allocator that records its calls in a shared allocation_counts.
+// Copies, including rebound copies, share the same counts and compare equal.
+template <class T>
+struct counting_allocator {
+  using value_type = T;
+
+  allocation_counts* counts;
+
+  explicit counting_allocator(allocation_counts& c) noexcept : counts(&c) {}
+
+  template <class U>
+  counting_allocator(const counting_allocator<U>& other) noexcept
+      : counts(other.counts) {}
+
+  T* allocate(std::size_t n) {
+    ++counts->allocations;
+    return std::allocator<T>().allocate(n);
+  }
+
+  void deallocate(T* p, std::size_t n) noexcept {
+    ++counts->deallocations;
+    std::allocator<T>().deallocate(p, n);
+  }
+
+  template <class U>
+  friend bool operator==(const counting_allocator& lhs,
+                         const counting_allocator<U>& rhs) noexcept {
+    return lhs.counts == rhs.counts;
+  }
+
+  template <class U>
+  friend bool operator!=(const counting_allocator& lhs,
+                         const counting_allocator<U>& rhs) noexcept {
+    return lhs.counts != rhs.counts;
+  }
+};
+
+}  // namespace isocpp_p1950::testing
+
+#ifdef ISOCPP_P1950_DEFINE_COUNTING_NEW_DELETE
+
+namespace isocpp_p1950::testing::detail {
+
+inline void* counted_allocate(std::size_t size, std::size_t alignment,
+                              bool nothrow) {
+  if (size == 0) size = 1;
+  void* p = nullptr;
+  if (alignment <= alignof(std::max_align_t)) {
+    p = std::malloc(size);
+  } else {
+#ifdef _MSC_VER
+    p = _aligned_malloc(size, alignment);
+#else
+    // aligned_alloc requires the size to be a multiple of the alignment.
+    p = std::aligned_alloc(alignment,
+                           (size + alignment - 1) / alignment * alignment);
+#endif
+  }
+  if (!p) {
+    if (nothrow) return nullptr;
+#ifdef ISOCPP_P1950_NO_EXCEPTIONS
+    std::abort();
+#else
+    throw std::bad_alloc();
+#endif
+  }
+  ++thread_allocation_counts().allocations;
+  return p;
+}
+
+inline void counted_deallocate(void* p, std::size_t alignment) noexcept {
+  if (!p) return;
+  ++thread_allocation_counts().deallocations;
+#ifdef _MSC_VER
+  if (alignment > alignof(std::max_align_t)) {
+    _aligned_free(p);
+    return;
+  }
+#else
+  (void)alignment;
+#endif
+  std::free(p);
+}
+
+inline const bool counting_new_delete_registered =
+    (counting_new_delete_installed() = true);
+
+}  // namespace isocpp_p1950::testing::detail
+
+// Replacement global allocation functions. Every form forwards to the
+// counting implementation so that no allocation escapes the count.
+void* operator new(std::size_t size) {
+  return isocpp_p1950::testing::detail::counted_allocate(
+      size, alignof(std::max_align_t), false);
+}
+void* operator new[](std::size_t size) {
+  return isocpp_p1950::testing::detail::counted_allocate(
+      size, alignof(std::max_align_t), false);
+}
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+  return isocpp_p1950::testing::detail::counted_allocate(
+      size, alignof(std::max_align_t), true);
+}
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+  return isocpp_p1950::testing::detail::counted_allocate(
+      size, alignof(std::max_align_t), true);
+}
+void* operator new(std::size_t size, std::align_val_t al) {
+  return isocpp_p1950::testing::detail::counted_allocate(
+      size, static_cast<std::size_t>(al), false);
+}
+void* operator new[](std::size_t size, std::align_val_t al) {
+  return isocpp_p1950::testing::detail::counted_allocate(
+      size, static_cast<std::size_t>(al), false);
+}
+void* operator new(std::size_t size, std::align_val_t al,
+                   const std::nothrow_t&) noexcept {
+  return isocpp_p1950::testing::detail::counted_allocate(
+      size, static_cast<std::size_t>(al), true);
+}
+void* operator new[](std::size_t size, std::align_val_t al,
+                     const std::nothrow_t&) noexcept {
+  return isocpp_p1950::testing::detail::counted_allocate(
+      size, static_cast<std::size_t>(al), true);
+}
+
+void operator delete(void* p) noexcept {
+  isocpp_p1950::testing::detail::counted_deallocate(
+      p, alignof(std::max_align_t));
+}
+void operator delete[](void* p) noexcept {
+  isocpp_p1950::testing::detail::counted_deallocate(
+      p, alignof(std::max_align_t));
+}
+void operator delete(void* p, std::size_t) noexcept {
+  isocpp_p1950::testing::detail::counted_deallocate(
+      p, alignof(std::max_align_t));
+}
+void operator delete[](void* p, std::size_t) noexcept {
+  isocpp_p1950::testing::detail::counted_deallocate(
+      p, alignof(std::max_align_t));
+}
+void operator delete(void* p, const std::nothrow_t&) noexcept {
+  isocpp_p1950::testing::detail::counted_deallocate(
+      p, alignof(std::max_align_t));
+}
+void operator delete[](void* p, const std::nothrow_t&) noexcept {
+  isocpp_p1950::testing::detail::counted_deallocate(
+      p, alignof(std::max_align_t));
+}
+void operator delete(void* p, std::align_val_t al) noexcept {
+  isocpp_p1950::testing::detail::counted_deallocate(
+      p, static_cast<std::size_t>(al));
+}
+void operator delete[](void* p, std::align_val_t al) noexcept {
+  isocpp_p1950::testing::detail::counted_deallocate(
+      p, static_cast<std::size_t>(al));
+}
+void operator delete(void* p, std::size_t, std::align_val_t al) noexcept {
+  isocpp_p1950::testing::detail::counted_deallocate(
+      p, static_cast<std::size_t>(al));
+}
+void operator delete[](void* p, std::size_t, std::align_val_t al) noexcept {
+  isocpp_p1950::testing::detail::counted_deallocate(
+      p, static_cast<std::size_t>(al));
+}
+void operator delete(void* p, std::align_val_t al,
+                     const std::nothrow_t&) noexcept {
+  isocpp_p1950::testing::detail::counted_deallocate(
+      p, static_cast<std::size_t>(al));
+}
+void operator delete[](void* p, std::align_val_t al,
+                       const std::nothrow_t&) noexcept {
+  isocpp_p1950::testing::detail::counted_deallocate(
+      p, static_cast<std::size_t>(al));
+}
+
+#endif  // ISOCPP_P1950_DEFINE_COUNTING_NEW_DELETE
+
+#endif  // ISOCPP_P1950_ALLOCATION_COUNTING_H
@@ -0,0 +1,494 @@
+/* Copyright (c) 2019 The Indirect Value Authors. All Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+==============================================================================*/
+
+#ifndef ISOCPP_P1950_ALLOCATION_PROFILE_H
+#define ISOCPP_P1950_ALLOCATION_PROFILE_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#if __has_include(<source_location>)
+#include <source_location>
+#endif
+
+#if __has_include(<execinfo.h>)
+#include <execinfo.h>
+#define ISOCPP_P1950_HAS_BACKTRACE
+#endif
+
+#include "indirect_value.h"
+
+namespace isocpp_p1950 {
+
+// The source location that created an allocation.
+struct allocation_site {
+  const char* file = "unknown";
+  unsigned line = 0;
+  const char* function = "unknown";
+
+#if defined(__cpp_lib_source_location)
+  static constexpr allocation_site current(
+      std::source_location loc = std::source_location::current()) noexcept {
+    return {loc.file_name(), static_cast<unsigned>(loc.line()),
+            loc.function_name()};
+  }
+#endif
+};
+
+// Expands to the allocation_site of the expression it appears in.
+#if defined(__cpp_lib_source_location)
+#define ISOCPP_P1950_ALLOCATION_SITE() \
+  ::isocpp_p1950::allocation_site::current()
+#else
+#define ISOCPP_P1950_ALLOCATION_SITE() \
+  ::isocpp_p1950::allocation_site { __FILE__, __LINE__, __func__ }
+#endif
+
+// The outstanding allocations attributed to one call site.
+struct allocation_site_usage {
+  allocation_site site;
+  std::size_t allocations = 0;
+  std::size_t bytes = 0;
+  // How many of the allocations captured a stack trace.
+  std::size_t sampled = 0;
+};
+
+// A process-wide table of outstanding profiled allocations.
+//
+// Allocations are made by profiled_copy and profiled_delete, by
+// make_profiled_indirect_value and by allocate_profiled_indirect_value. Each
+// is attributed to the call site that created it; a deep copy inherits the
+// site of the value it copies. When a sample rate N is set, one allocation in
+// N per thread also records a stack trace, where the platform provides
+// backtrace().
+//
+// The table is sharded by address so that threads allocating concurrently
+// rarely contend.
+//
+// make_indirect_value and allocate_indirect_value do not record their call
+// site themselves: a defaulted std::source_location parameter would have to
+// follow their parameter pack, which would then no longer be deduced. The
+// profiled factories take the site as their first argument instead.
+class allocation_profile {
+  struct record {
+    std::size_t bytes;
+    allocation_site site;
+    std::vector<void*> stack;
+  };
+
+  struct shard {
+    std::mutex mutex;
+    std::unordered_map<const void*, record> records;
+  };
+
+  static constexpr std::size_t shard_count = 16;
+  static constexpr int max_stack_depth = 32;
+
+ public:
+  // Enables or disables recording; allocations made while disabled are not
+  // tracked. Recording is enabled by default.
+  static void set_enabled(bool enabled) noexcept {
+    enabled_.store(enabled, std::memory_order_relaxed);
+  }
+
+  static bool enabled() noexcept {
+    return enabled_.load(std::memory_order_relaxed);
+  }
+
+  // Captures a stack trace for one in every `n` allocations on each thread.
+  // Zero, the default, disables stack capture.
+  static void set_stack_sample_rate(std::size_t n) noexcept {
+    sample_rate_.store(n, std::memory_order_relaxed);
+  }
+
+  static std::size_t stack_sample_rate() noexcept {
+    return sample_rate_.load(std::memory_order_relaxed);
+  }
+
+  // Records `bytes` allocated at `p` by `site`.
+  static void record_allocation(const void* p, std::size_t bytes,
+                                const allocation_site& site) {
+    if (!p || !enabled()) return;
+    record r{bytes, site, {}};
+    if (should_sample()) r.stack = capture_stack();
+    auto& s = shard_for(p);
+    std::lock_guard<std::mutex> lock(s.mutex);
+    s.records.insert_or_assign(p, std::move(r));
+  }
+
+  // Attributes the allocation at `p` to the site that allocated `source`, if
+  // `source` is tracked.
+  static void inherit_site(const void* p, const void* source) {
+    if (!p || !enabled()) return;
+    allocation_site site;
+    {
+      auto& s = shard_for(source);
+      std::lock_guard<std::mutex> lock(s.mutex);
+      auto it = s.records.find(source);
+      if (it == s.records.end()) return;
+      site = it->second.site;
+    }
+    auto& s = shard_for(p);
+    std::lock_guard<std::mutex> lock(s.mutex);
+    auto it = s.records.find(p);
+    if (it != s.records.end()) it->second.site = site;
+  }
+
+  // Forgets the allocation at `p`.
+  static void record_deallocation(const void* p) noexcept {
+    if (!p) return;
+    auto& s = shard_for(p);
+    std::lock_guard<std::mutex> lock(s.mutex);
+    s.records.erase(p);
+  }
+
+  // Forgets every outstanding allocation.
+  static void clear() noexcept {
+    for (auto& s : shards()) {
+      std::lock_guard<std::mutex> lock(s.mutex);
+      s.records.clear();
+    }
+  }
+
+  static std::size_t outstanding_allocations() noexcept {
+    std::size_t n = 0;
+    for (auto& s : shards()) {
+      std::lock_guard<std::mutex> lock(s.mutex);
+      n += s.records.size();
+    }
+    return n;
+  }
+
+  static std::size_t outstanding_bytes() noexcept {
+    std::size_t n = 0;
+    for (auto& s : shards()) {
+      std::lock_guard<std::mutex> lock(s.mutex);
+      for (const auto& r : s.records) n += r.second.bytes;
+    }
+    return n;
+  }
+
+  // Outstanding allocations grouped by call site, largest first.
+  static std::vector<allocation_site_usage> by_site() {
+    std::map<site_key, allocation_site_usage> groups;
+    for_each_record([&groups](const record& r) {
+      auto& g = groups[key_of(r.site)];
+      g.site = r.site;
+      ++g.allocations;
+      g.bytes += r.bytes;
+      if (!r.stack.empty()) ++g.sampled;
+    });
+    std::vector<allocation_site_usage> usage;
+    usage.reserve(groups.size());
+    for (auto& g : groups) usage.push_back(g.second);
+    std::stable_sort(usage.begin(), usage.end(),
+                     [](const auto& a, const auto& b) {
+                       return a.bytes > b.bytes;
+                     });
+    return usage;
+  }
+
+  // Writes the outstanding allocations as a pprof legacy heap profile, in
+  // the symbolized form that begins with a "--- symbol" section.
+  //
+  // Every stack starts with a synthetic frame for the call site, whose
+  // address maps to "function (file:line)" in the symbol section; sampled
+  // allocations continue with their captured frames. Only outstanding
+  // allocations are tracked, so the in-use and cumulative columns agree.
+  static void write_pprof(std::ostream& os) {
+    std::map<std::pair<site_key, std::vector<void*>>, allocation_site_usage>
+        groups;
+    for_each_record([&groups](const record& r) {
+      auto& g = groups[{key_of(r.site), r.stack}];
+      g.site = r.site;
+      ++g.allocations;
+      g.bytes += r.bytes;
+    });
+
+    std::map<site_key, std::uintptr_t> site_addresses;
+    std::map<void*, std::string> frame_names;
+    std::size_t total_allocations = 0;
+    std::size_t total_bytes = 0;
+    for (const auto& g : groups) {
+      // Synthetic addresses lie below the first page, which is never mapped.
+      site_addresses.emplace(g.first.first, site_addresses.size() + 1);
+      for (void* frame : g.first.second) frame_names.emplace(frame, "");
+      total_allocations += g.second.allocations;
+      total_bytes += g.second.bytes;
+    }
+    name_frames(frame_names);
+
+    os << "--- symbol\n";
+    for (const auto& s : site_addresses) {
+      os << "0x" << std::hex << s.second << std::dec << ' '
+         << std::get<2>(s.first) << " (" << std::get<0>(s.first) << ':'
+         << std::get<1>(s.first) << ")\n";
+    }
+    for (const auto& f : frame_names) {
+      os << f.first << ' ' << f.second << '\n';
+    }
+    os << "---\n--- heap\n";
+    os << "heap profile: " << total_allocations << ": " << total_bytes << " ["
+       << total_allocations << ": " << total_bytes << "] @ heapprofile\n";
+    for (const auto& g : groups) {
+      const auto& usage = g.second;
+      os << usage.allocations << ": " << usage.bytes << " ["
+         << usage.allocations << ": " << usage.bytes << "] @ 0x" << std::hex
+         << site_addresses[g.first.first] << std::dec;
+      for (void* frame : g.first.second) os << ' ' << frame;
+      os << '\n';
+    }
+  }
+
+  // The site used for allocations made inside this thread's innermost
+  // allocation_site_scope, or an unknown site outside any scope.
+  static allocation_site current_site() noexcept {
+    return current_site_ ? *current_site_ : allocation_site{};
+  }
+
+ private:
+  friend class allocation_site_scope;
+
+  using site_key = std::tuple<std::string, unsigned, std::string>;
+
+  static site_key key_of(const allocation_site& site) {
+    return {site.file, site.line, site.function};
+  }
+
+  static std::array<shard, shard_count>& shards() noexcept {
+    static std::array<shard, shard_count> instance;
+    return instance;
+  }
+
+  static shard& shard_for(const void* p) noexcept {
+    // Heap addresses share their low bits, so mix before picking a shard.
+    auto h = reinterpret_cast<std::uintptr_t>(p) >> 4;
+    h ^= h >> 7;
+    return shards()[h % shard_count];
+  }
+
+  template <class F>
+  static void for_each_record(F f) {
+    for (auto& s : shards()) {
+      std::lock_guard<std::mutex> lock(s.mutex);
+      for (const auto& r : s.records) f(r.second);
+    }
+  }
+
+  static bool should_sample() noexcept {
+    const std::size_t rate = stack_sample_rate();
+    if (rate == 0) return false;
+    static thread_local std::size_t countdown = 0;
+    if (countdown == 0) countdown = rate;
+    return --countdown == 0;
+  }
+
+  static std::vector<void*> capture_stack() {
+#if defined(ISOCPP_P1950_HAS_BACKTRACE)
+    void* frames[max_stack_depth];
+    const int depth = ::backtrace(frames, max_stack_depth);
+    // Drop this function's own frame.
+    if (depth > 1) return std::vector<void*>(frames + 1, frames + depth);
+#endif
+    return {};
+  }
+
+  static void name_frames(std::map<void*, std::string>& names) {
+#if defined(ISOCPP_P1950_HAS_BACKTRACE)
+    std::vector<void*> frames;
+    for (const auto& n : names) frames.push_back(n.first);
+    if (frames.empty()) return;
+    char** symbols =
+        ::backtrace_symbols(frames.data(), static_cast<int>(frames.size()));
+    if (!symbols) return;
+    for (std::size_t i = 0; i < frames.size(); ++i) {
+      names[frames[i]] = symbols[i];
+    }
+    std::free(symbols);
+#else
+    (void)names;
+#endif
+  }
+
+  inline static std::atomic<bool> enabled_{true};
+  inline static std::atomic<std::size_t> sample_rate_{0};
+  inline static thread_local const allocation_site* current_site_ = nullptr;
+};
+
+// Attributes allocations made by profiling_allocator on this thread to
+// `site` for the lifetime of the scope.
+class allocation_site_scope {
+ public:
+  explicit allocation_site_scope(const allocation_site& site) noexcept
+      : site_(site), previous_(allocation_profile::current_site_) {
+    allocation_profile::current_site_ = &site_;
+  }
+
+  allocation_site_scope(const allocation_site_scope&) = delete;
+  allocation_site_scope& operator=(const allocation_site_scope&) = delete;
+
+  ~allocation_site_scope() { allocation_profile::current_site_ = previous_; }
+
+ private:
+  allocation_site site_;
+  const allocation_site* previous_;
+};
+
+// A deleter that removes the pointee from the allocation profile.
+template <class T>
+struct profiled_delete {
+  void operator()(T* p) const noexcept {
+    allocation_profile::record_deallocation(p);
+    delete p;
+  }
+};
+
+// A copier that records the copies it makes, attributing each to the site
+// of the value it copies.
+template <class T>
+struct profiled_copy {
+  using deleter_type = profiled_delete<T>;
+
+  T* operator()(const T& t) const {
+    T* p = detail::new_object<T>(t);
+    allocation_profile::record_allocation(p, sizeof(T),
+                                          allocation_profile::current_site());
+    allocation_profile::inherit_site(p, &t);
+    return p;
+  }
+};
+
+template <class T>
+using profiled_indirect_value =
+    indirect_value<T, profiled_copy<T>, profiled_delete<T>>;
+
+// Constructs a profiled_indirect_value whose pointee is attributed to
+// `site`, normally ISOCPP_P1950_ALLOCATION_SITE().
+template <class T, class... Ts>
+profiled_indirect_value<T> make_profiled_indirect_value(
+    const allocation_site& site, Ts&&... ts) {
+  T* p = detail::new_object<T>(std::forward<Ts>(ts)...);
+  allocation_profile::record_allocation(p, sizeof(T), site);
+  return profiled_indirect_value<T>(p);
+}
+
+// An allocator adaptor that records the allocations made through A.
+//
+// Allocations are attributed to the current allocation_site_scope, and an
+// object copy constructed into profiled storage inherits the site of its
+// source, so deep copies made by allocate_indirect_value's copier are
+// attributed to the original call site.
+template <class A>
+class profiling_allocator : private A {
+  using traits = std::allocator_traits<A>;
+
+ public:
+  using value_type = typename traits::value_type;
+  using propagate_on_container_copy_assignment =
+      typename traits::propagate_on_container_copy_assignment;
+  using propagate_on_container_move_assignment =
+      typename traits::propagate_on_container_move_assignment;
+  using propagate_on_container_swap =
+      typename traits::propagate_on_container_swap;
+  using is_always_equal = typename traits::is_always_equal;
+
+  template <class U>
+  struct rebind {
+    using other =
+        profiling_allocator<typename traits::template rebind_alloc<U>>;
+  };
+
+  profiling_allocator() = default;
+
+  explicit profiling_allocator(const A& a) noexcept : A(a) {}
+
+  template <class B>
+  profiling_allocator(const profiling_allocator<B>& other) noexcept
+      : A(other.underlying()) {}
+
+  value_type* allocate(std::size_t n) {
+    A& a = *this;
+    value_type* p = detail::allocate_storage(a, n);
+    allocation_profile::record_allocation(p, n * sizeof(value_type),
+                                          allocation_profile::current_site());
+    return p;
+  }
+
+  void deallocate(value_type* p, std::size_t n) noexcept {
+    allocation_profile::record_deallocation(p);
+    A& a = *this;
+    traits::deallocate(a, p, n);
+  }
+
+  template <class U, class... Ts>
+  void construct(U* p, Ts&&... ts) {
+    A& a = *this;
+    std::allocator_traits<A>::construct(a, p, std::forward<Ts>(ts)...);
+    if constexpr (sizeof...(Ts) == 1 &&
+                  (std::is_same_v<std::decay_t<Ts>, U> && ...)) {
+      allocation_profile::inherit_site(p, std::addressof(ts)...);
+    }
+  }
+
+  const A& underlying() const noexcept { return *this; }
+
+  template <class B>
+  friend bool operator==(const profiling_allocator& lhs,
+                         const profiling_allocator<B>& rhs) noexcept {
+    return lhs.underlying() == rhs.underlying();
+  }
+
+  template <class B>
+  friend bool operator!=(const profiling_allocator& lhs,
+                         const profiling_allocator<B>& rhs) noexcept {
+    return !(lhs == rhs);
+  }
+};
+
+// Allocates an indirect_value through profiling_allocator<A>, attributing
+// the pointee to `site`.
+template <class T, class A, class... Ts>
+auto allocate_profiled_indirect_value(const allocation_site& site,
+                                      std::allocator_arg_t, const A& a,
+                                      Ts&&... ts) {
+  profiling_allocator<A> profiled(a);
+  allocation_site_scope scope(site);
+  return allocate_indirect_value<T>(std::allocator_arg, profiled,
+                                    std::forward<Ts>(ts)...);
+}
+
+}  // namespace isocpp_p1950
+
+#endif  // ISOCPP_P1950_ALLOCATION_PROFILE_H
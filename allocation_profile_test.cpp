@@ -0,0 +1,170 @@
+/* Copyright (c) 2019 The Indirect Value Authors. All Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+==============================================================================*/
+
+#include "allocation_profile.h"
+
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "catch2/catch_test_macros.hpp"
+
+using isocpp_p1950::allocate_profiled_indirect_value;
+using isocpp_p1950::allocation_profile;
+using isocpp_p1950::allocation_site;
+using isocpp_p1950::make_profiled_indirect_value;
+using isocpp_p1950::profiled_indirect_value;
+
+namespace {
+
+struct Payload {
+  char bytes[48] = {};
+};
+
+// Resets the process-wide profile around each test.
+struct profile_fixture {
+  profile_fixture() {
+    allocation_profile::clear();
+    allocation_profile::set_enabled(true);
+    allocation_profile::set_stack_sample_rate(0);
+  }
+  ~profile_fixture() {
+    allocation_profile::clear();
+    allocation_profile::set_stack_sample_rate(0);
+  }
+};
+
+profiled_indirect_value<Payload> make_at_helper_site() {
+  return make_profiled_indirect_value<Payload>(
+      ISOCPP_P1950_ALLOCATION_SITE());
+}
+
+}  // namespace
+
+TEST_CASE("Profiled allocations are attributed to their call site",
+          "[allocation_profile.site]") {
+  profile_fixture fixture;
+  GIVEN("Values made at two call sites") {
+    auto a = make_at_helper_site();
+    auto b = make_at_helper_site();
+    const allocation_site here = ISOCPP_P1950_ALLOCATION_SITE();
+    auto c = make_profiled_indirect_value<int>(here, 42);
+
+    THEN("They are grouped by site, largest first") {
+      REQUIRE(allocation_profile::outstanding_allocations() == 3);
+      REQUIRE(allocation_profile::outstanding_bytes() ==
+              2 * sizeof(Payload) + sizeof(int));
+      const auto usage = allocation_profile::by_site();
+      REQUIRE(usage.size() == 2);
+      REQUIRE(usage[0].allocations == 2);
+      REQUIRE(usage[0].bytes == 2 * sizeof(Payload));
+      REQUIRE(usage[1].site.line == here.line);
+      REQUIRE(std::string(usage[1].site.file) == here.file);
+      REQUIRE(*c == 42);
+    }
+    WHEN("Values are destroyed") {
+      a = {};
+      THEN("Their allocations are no longer outstanding") {
+        REQUIRE(allocation_profile::outstanding_allocations() == 2);
+      }
+    }
+  }
+}
+
+TEST_CASE("Deep copies inherit the site of their source",
+          "[allocation_profile.copy]") {
+  profile_fixture fixture;
+  auto original = make_at_helper_site();
+  const auto site = allocation_profile::by_site().front().site;
+  auto copy = original;
+  REQUIRE(&*copy != &*original);
+  const auto usage = allocation_profile::by_site();
+  REQUIRE(usage.size() == 1);
+  REQUIRE(usage[0].allocations == 2);
+  REQUIRE(usage[0].site.line == site.line);
+}
+
+TEST_CASE("Recording can be disabled", "[allocation_profile.enabled]") {
+  profile_fixture fixture;
+  allocation_profile::set_enabled(false);
+  auto untracked = make_at_helper_site();
+  allocation_profile::set_enabled(true);
+  REQUIRE(allocation_profile::outstanding_allocations() == 0);
+  untracked = {};
+  REQUIRE(allocation_profile::outstanding_allocations() == 0);
+}
+
+TEST_CASE("Allocator-aware values are profiled",
+          "[allocation_profile.allocator]") {
+  profile_fixture fixture;
+  const allocation_site here = ISOCPP_P1950_ALLOCATION_SITE();
+  std::allocator<std::string> a;
+  {
+    auto v = allocate_profiled_indirect_value<std::string>(
+        here, std::allocator_arg, a, "profiled");
+    REQUIRE(*v == "profiled");
+    auto copy = v;
+    REQUIRE(*copy == "profiled");
+
+    const auto usage = allocation_profile::by_site();
+    REQUIRE(usage.size() == 1);
+    REQUIRE(usage[0].allocations == 2);
+    REQUIRE(usage[0].bytes == 2 * sizeof(std::string));
+    REQUIRE(usage[0].site.line == here.line);
+  }
+  REQUIRE(allocation_profile::outstanding_allocations() == 0);
+}
+
+TEST_CASE("Stack traces are sampled at the configured rate",
+          "[allocation_profile.sampling]") {
+  profile_fixture fixture;
+  allocation_profile::set_stack_sample_rate(4);
+  std::vector<profiled_indirect_value<Payload>> values;
+  for (int i = 0; i < 16; ++i) values.push_back(make_at_helper_site());
+  const auto usage = allocation_profile::by_site();
+  REQUIRE(usage.size() == 1);
+#if defined(ISOCPP_P1950_HAS_BACKTRACE)
+  REQUIRE(usage[0].sampled == 4);
+#else
+  REQUIRE(usage[0].sampled == 0);
+#endif
+}
+
+TEST_CASE("The profile is written as a pprof heap profile",
+          "[allocation_profile.pprof]") {
+  profile_fixture fixture;
+  auto a = make_at_helper_site();
+  auto b = make_at_helper_site();
+  std::ostringstream os;
+  allocation_profile::write_pprof(os);
+  const std::string text = os.str();
+
+  REQUIRE(text.rfind("--- symbol\n0x1 ", 0) == 0);
+  REQUIRE(text.find("allocation_profile_test.cpp:") != std::string::npos);
+  REQUIRE(text.find("---\n--- heap\n") != std::string::npos);
+  const std::string totals = "heap profile: 2: " +
+                             std::to_string(2 * sizeof(Payload)) + " [2: " +
+                             std::to_string(2 * sizeof(Payload)) +
+                             "] @ heapprofile\n";
+  REQUIRE(text.find(totals) != std::string::npos);
+  REQUIRE(text.find("] @ 0x1\n") != std::string::npos);
+}
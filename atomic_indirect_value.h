@@ -0,0 +1,197 @@
+/* Copyright (c) 2019 The Indirect Value Authors. All Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+==============================================================================*/
+
+#ifndef ISOCPP_P1950_ATOMIC_INDIRECT_VALUE_H
+#define ISOCPP_P1950_ATOMIC_INDIRECT_VALUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#include "indirect_value.h"
+
+namespace isocpp_p1950 {
+
+namespace detail {
+
+// Readers register themselves in one of several counters, each on its own
+// cache line, so that concurrent loads from different threads do not contend
+// on a single shared counter.
+inline constexpr std::size_t reader_stripe_count = 16;
+inline constexpr std::size_t reader_stripe_alignment = 64;
+
+struct alignas(reader_stripe_alignment) reader_stripe {
+  std::atomic<std::size_t> count{0};
+};
+
+inline std::size_t this_thread_reader_stripe() noexcept {
+  static std::atomic<std::size_t> next_stripe{0};
+  thread_local const std::size_t stripe =
+      next_stripe.fetch_add(1, std::memory_order_relaxed) % reader_stripe_count;
+  return stripe;
+}
+
+}  // namespace detail
+
+// An indirect_value that can be read and replaced concurrently.
+//
+// Readers call load() which is wait-free: it never takes a lock and never
+// waits for a writer. The returned read_guard keeps the observed value alive
+// until the guard is destroyed. Writers are serialised with a mutex and, after
+// publishing a new value, wait until every reader that could still observe the
+// previous value has released its guard before the previous value is handed
+// back or destroyed (a two-phase epoch scheme in the style of RCU).
+//
+// Writers block while readers hold guards, so read_guards should be
+// short-lived. All read_guards must be released before the
+// atomic_indirect_value is destroyed.
+template <class T, class C = default_copy<T>,
+          class D = typename copier_traits<C>::deleter_type>
+class atomic_indirect_value {
+ public:
+  using value_type = indirect_value<T, C, D>;
+
+  class read_guard {
+   public:
+    constexpr read_guard() noexcept = default;
+
+    read_guard(read_guard&& g) noexcept
+        : ptr_(std::exchange(g.ptr_, nullptr)),
+          stripe_(std::exchange(g.stripe_, nullptr)) {}
+
+    read_guard& operator=(read_guard&& g) noexcept {
+      if (this != &g) {
+        release();
+        ptr_ = std::exchange(g.ptr_, nullptr);
+        stripe_ = std::exchange(g.stripe_, nullptr);
+      }
+      return *this;
+    }
+
+    read_guard(const read_guard&) = delete;
+    read_guard& operator=(const read_guard&) = delete;
+
+    ~read_guard() { release(); }
+
+    const T* get() const noexcept { return ptr_; }
+
+    const T* operator->() const noexcept { return ptr_; }
+
+    const T& operator*() const noexcept { return *ptr_; }
+
+    explicit operator bool() const noexcept { return ptr_ != nullptr; }
+
+   private:
+    friend class atomic_indirect_value;
+
+    read_guard(const T* ptr, detail::reader_stripe* stripe) noexcept
+        : ptr_(ptr), stripe_(stripe) {}
+
+    void release() noexcept {
+      if (stripe_) {
+        ptr_ = nullptr;
+        std::exchange(stripe_, nullptr)
+            ->count.fetch_sub(1, std::memory_order_release);
+      }
+    }
+
+    const T* ptr_ = nullptr;
+    detail::reader_stripe* stripe_ = nullptr;
+  };
+
+  atomic_indirect_value() = default;
+
+  explicit atomic_indirect_value(value_type v)
+      : current_(std::move(v)), published_(current_.operator->()) {}
+
+  atomic_indirect_value(const atomic_indirect_value&) = delete;
+  atomic_indirect_value& operator=(const atomic_indirect_value&) = delete;
+
+  read_guard load() const noexcept {
+    const std::size_t stripe = detail::this_thread_reader_stripe();
+    const std::size_t epoch = epoch_.load() & 1u;
+    detail::reader_stripe& counter = readers_[epoch][stripe];
+    // The registration must be visible before the pointer is read, so that a
+    // writer which replaces the pointer afterwards is guaranteed to wait for
+    // this reader.
+    counter.count.fetch_add(1);
+    return read_guard(published_.load(), &counter);
+  }
+
+  void store(value_type desired) { (void)exchange(std::move(desired)); }
+
+  // Publishes `desired` and returns the previous value once no reader can
+  // observe it any more.
+  value_type exchange(value_type desired) {
+    std::lock_guard<std::mutex> lock(writer_mutex_);
+    publish(desired);
+    return desired;
+  }
+
+  // Deep-copies the current value with its copier, applies `f` to the copy
+  // and publishes the result. An empty value is reported as by value().
+  template <class F>
+  void update(F&& f) {
+    value_type previous;
+    {
+      std::lock_guard<std::mutex> lock(writer_mutex_);
+      value_type next(current_);
+      std::forward<F>(f)(next.value());
+      publish(next);
+      previous = std::move(next);
+    }
+  }
+
+ private:
+  // Swaps `v` into current_ and waits for readers of the old value.
+  // On return `v` holds the old value. Must be called with writer_mutex_ held.
+  void publish(value_type& v) {
+    current_.swap(v);
+    published_.store(current_.operator->());
+    synchronize();
+  }
+
+  // Waits until every reader that registered before the new pointer was
+  // published has released its guard. Flipping the epoch first directs new
+  // readers to the other set of counters, so a steady stream of readers cannot
+  // starve the writer. Two flips drain both sets.
+  void synchronize() const noexcept {
+    for (int phase = 0; phase < 2; ++phase) {
+      const std::size_t drained = epoch_.fetch_add(1) & 1u;
+      for (const auto& stripe : readers_[drained]) {
+        while (stripe.count.load() != 0) {
+          std::this_thread::yield();
+        }
+      }
+    }
+  }
+
+  value_type current_;
+  std::atomic<const T*> published_{nullptr};
+  mutable std::atomic<std::size_t> epoch_{0};
+  mutable detail::reader_stripe readers_[2][detail::reader_stripe_count];
+  std::mutex writer_mutex_;
+};
+
+}  // namespace isocpp_p1950
+
+#endif  // ISOCPP_P1950_ATOMIC_INDIRECT_VALUE_H
@@ -0,0 +1,163 @@
+/* Copyright (c) 2019 The Indirect Value Authors. All Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+==============================================================================*/
+
+#include "atomic_indirect_value.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "catch2/catch_test_macros.hpp"
+
+using isocpp_p1950::atomic_indirect_value;
+using isocpp_p1950::bad_indirect_value_access;
+using isocpp_p1950::indirect_value;
+using isocpp_p1950::make_indirect_value;
+
+namespace {
+struct Table {
+  int version = 0;
+  int checksum = 0;
+
+  Table() { ++live; }
+  Table(int v) : version(v), checksum(-v) { ++live; }
+  Table(const Table& t) : version(t.version), checksum(t.checksum) { ++live; }
+  Table& operator=(const Table&) = default;
+  ~Table() { --live; }
+
+  bool consistent() const { return checksum == -version; }
+
+  inline static std::atomic<int> live{0};
+};
+}  // namespace
+
+TEST_CASE("Load from an atomic_indirect_value",
+          "[atomic_indirect_value.load]") {
+  GIVEN("A default constructed atomic_indirect_value") {
+    atomic_indirect_value<int> a;
+    THEN("Loading gives an empty guard") {
+      auto guard = a.load();
+      REQUIRE(!guard);
+      REQUIRE(guard.get() == nullptr);
+    }
+  }
+  GIVEN("An atomic_indirect_value constructed from an indirect_value") {
+    atomic_indirect_value<int> a(make_indirect_value<int>(42));
+    THEN("Loading observes the value") {
+      auto guard = a.load();
+      REQUIRE(guard);
+      REQUIRE(*guard == 42);
+    }
+    THEN("Several guards can be held at once") {
+      auto g1 = a.load();
+      auto g2 = a.load();
+      REQUIRE(g1.get() == g2.get());
+    }
+    THEN("A moved-from guard is empty") {
+      auto g1 = a.load();
+      auto g2 = std::move(g1);
+      REQUIRE(!g1);
+      REQUIRE(*g2 == 42);
+    }
+  }
+}
+
+TEST_CASE("Store and exchange on an atomic_indirect_value",
+          "[atomic_indirect_value.store]") {
+  GIVEN("An engaged atomic_indirect_value") {
+    atomic_indirect_value<int> a(make_indirect_value<int>(1));
+    WHEN("Exchanging with a new value") {
+      indirect_value<int> old = a.exchange(make_indirect_value<int>(2));
+      THEN("The old value is returned and the new value is observed") {
+        REQUIRE(*old == 1);
+        REQUIRE(*a.load() == 2);
+      }
+    }
+    WHEN("Storing an empty value") {
+      a.store(indirect_value<int>());
+      THEN("Loading gives an empty guard") { REQUIRE(!a.load()); }
+    }
+  }
+}
+
+TEST_CASE("Update an atomic_indirect_value", "[atomic_indirect_value.update]") {
+  GIVEN("An engaged atomic_indirect_value") {
+    atomic_indirect_value<Table> a(make_indirect_value<Table>(1));
+    WHEN("An update is applied while a reader holds a guard") {
+      auto before = a.load();
+      std::thread writer([&a] { a.update([](Table& t) { t = Table(2); }); });
+      THEN("The reader still sees the original value") {
+        REQUIRE(before->version == 1);
+        before = {};
+        writer.join();
+        REQUIRE(a.load()->version == 2);
+      }
+    }
+  }
+#ifndef ISOCPP_P1950_NO_EXCEPTIONS
+  GIVEN("An empty atomic_indirect_value") {
+    atomic_indirect_value<Table> a;
+    THEN("Updating throws and leaves the value empty") {
+      REQUIRE_THROWS_AS(a.update([](Table&) {}), bad_indirect_value_access);
+      REQUIRE(!a.load());
+    }
+  }
+#endif
+  REQUIRE(Table::live == 0);
+}
+
+TEST_CASE("Concurrent readers never observe a torn or reclaimed value",
+          "[atomic_indirect_value.concurrency]") {
+  {
+    atomic_indirect_value<Table> a(make_indirect_value<Table>(0));
+    std::atomic<bool> done{false};
+    std::atomic<int> inconsistent{0};
+
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 4; ++i) {
+      readers.emplace_back([&] {
+        int last_seen = 0;
+        while (!done) {
+          auto guard = a.load();
+          if (!guard->consistent() || guard->version < last_seen) {
+            ++inconsistent;
+          }
+          last_seen = guard->version;
+        }
+      });
+    }
+
+    constexpr int updates = 200;
+    for (int v = 1; v <= updates; ++v) {
+      if (v % 2) {
+        a.update([v](Table& t) { t = Table(v); });
+      } else {
+        a.store(make_indirect_value<Table>(v));
+      }
+    }
+    done = true;
+    for (auto& r : readers) r.join();
+
+    REQUIRE(inconsistent == 0);
+    REQUIRE(a.load()->version == updates);
+    REQUIRE(Table::live == 1);
+  }
+  REQUIRE(Table::live == 0);
+}
@@ -0,0 +1,415 @@
+/* Copyright (c) 2019 The Indirect Value Authors. All Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+==============================================================================*/
+
+// Measures how indirect_value create, copy and destroy throughput scales with
+// the number of threads, for several copier and allocator choices:
+//   default_copy        make_indirect_value, global operator new.
+//   std::allocator      allocate_indirect_value over std::allocator.
+//   pmr new_delete      polymorphic_allocator over new_delete_resource.
+//   pmr sync pool       one synchronized_pool_resource shared by all threads.
+//   pmr unsync pool     one unsynchronized_pool_resource per thread; local
+//                       pattern only, since it cannot free across threads.
+//
+// Each configuration runs two patterns:
+//   local      every thread creates a batch, copies it and destroys both.
+//   xthread    producer threads create values and hand them through a
+//              single-producer ring to a consumer that destroys them, so
+//              every pointee is freed on a thread other than the one that
+//              allocated it. Thread counts are rounded up to pairs.
+//
+// Every operation is timed individually for the latency percentiles. The
+// amount of work per thread is fixed, threads start together at a barrier,
+// and each configuration runs several times with the median run reported,
+// which keeps results comparable across allocator choices on one machine.
+// RSS growth is the change in resident memory over the runs of a
+// configuration, read from /proc/self/statm where available.
+//
+// Usage: allocation_scaling_benchmark [max_threads]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if __has_include(<memory_resource>)
+#include <memory_resource>
+#endif
+
+#if defined(__linux__)
+#include <unistd.h>
+#endif
+
+#include "benchmark.h"
+#include "indirect_value.h"
+
+using isocpp_p1950::allocate_indirect_value;
+using isocpp_p1950::indirect_value;
+using isocpp_p1950::make_indirect_value;
+using isocpp_p1950::benchmark::do_not_optimize;
+
+namespace {
+
+constexpr std::size_t ops_per_thread = std::size_t{1} << 18;
+constexpr std::size_t batch = 256;
+constexpr std::size_t ring_capacity = 1024;
+constexpr int repetitions = 3;
+
+struct Payload {
+  std::uint64_t words[8] = {};
+};
+
+using clock_type = std::chrono::steady_clock;
+
+std::uint32_t elapsed_ns(clock_type::time_point start) {
+  return static_cast<std::uint32_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(clock_type::now() -
+                                                           start)
+          .count());
+}
+
+// Resident set size in KiB, or nullopt where it cannot be read.
+std::optional<long> resident_kib() {
+#if defined(__linux__)
+  if (std::FILE* f = std::fopen("/proc/self/statm", "r")) {
+    long size = 0;
+    long resident = 0;
+    const int read = std::fscanf(f, "%ld %ld", &size, &resident);
+    std::fclose(f);
+    if (read == 2) return resident * (sysconf(_SC_PAGESIZE) / 1024);
+  }
+#endif
+  return std::nullopt;
+}
+
+// Releases all waiting threads at once so that they start together.
+class start_barrier {
+ public:
+  explicit start_barrier(std::size_t n) : remaining_(n) {}
+
+  void arrive_and_wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (--remaining_ == 0) {
+      cv_.notify_all();
+    } else {
+      cv_.wait(lock, [this] { return remaining_ == 0; });
+    }
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::size_t remaining_;
+};
+
+// A bounded single-producer, single-consumer ring.
+template <class T>
+class spsc_ring {
+ public:
+  spsc_ring() : slots_(ring_capacity) {}
+
+  bool try_push(T& value) {
+    const std::size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - head_.load(std::memory_order_acquire) == ring_capacity) {
+      return false;
+    }
+    slots_[tail % ring_capacity].emplace(std::move(value));
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool try_pop(std::optional<T>& value) {
+    const std::size_t head = head_.load(std::memory_order_relaxed);
+    if (head == tail_.load(std::memory_order_acquire)) return false;
+    auto& slot = slots_[head % ring_capacity];
+    value.emplace(std::move(*slot));
+    slot.reset();
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+ private:
+  std::vector<std::optional<T>> slots_;
+  alignas(64) std::atomic<std::size_t> head_{0};
+  alignas(64) std::atomic<std::size_t> tail_{0};
+};
+
+// Policies create and copy values; a policy object is shared by all the
+// threads of a run and is told which thread is asking.
+
+struct default_policy {
+  static constexpr const char* name = "default_copy";
+  static constexpr bool cross_thread = true;
+  using value = indirect_value<Payload>;
+
+  explicit default_policy(std::size_t) {}
+  value make(std::size_t) { return make_indirect_value<Payload>(); }
+  value copy(std::size_t, const value& v) { return v; }
+};
+
+struct std_allocator_policy {
+  static constexpr const char* name = "std::allocator";
+  static constexpr bool cross_thread = true;
+  using value = decltype(allocate_indirect_value<Payload>(
+      std::allocator_arg, std::declval<std::allocator<Payload>&>()));
+
+  explicit std_allocator_policy(std::size_t) {}
+  value make(std::size_t) {
+    return allocate_indirect_value<Payload>(std::allocator_arg, alloc_);
+  }
+  value copy(std::size_t, const value& v) { return v; }
+
+  std::allocator<Payload> alloc_;
+};
+
+#if defined(__cpp_lib_memory_resource)
+using pmr_value = decltype(allocate_indirect_value<Payload>(
+    std::allocator_arg,
+    std::declval<std::pmr::polymorphic_allocator<Payload>&>()));
+
+// Copies are allocator-extended so that they stay in the thread's resource;
+// a plain copy would select the default resource.
+template <class Derived>
+struct pmr_policy_base {
+  using value = pmr_value;
+  value make(std::size_t thread) {
+    std::pmr::polymorphic_allocator<Payload> a(self().resource(thread));
+    return allocate_indirect_value<Payload>(std::allocator_arg, a);
+  }
+  value copy(std::size_t thread, const value& v) {
+    std::pmr::polymorphic_allocator<Payload> a(self().resource(thread));
+    return value(std::allocator_arg, a, v);
+  }
+  Derived& self() { return static_cast<Derived&>(*this); }
+};
+
+struct pmr_new_delete_policy : pmr_policy_base<pmr_new_delete_policy> {
+  static constexpr const char* name = "pmr new_delete";
+  static constexpr bool cross_thread = true;
+  explicit pmr_new_delete_policy(std::size_t) {}
+  std::pmr::memory_resource* resource(std::size_t) {
+    return std::pmr::new_delete_resource();
+  }
+};
+
+struct pmr_sync_pool_policy : pmr_policy_base<pmr_sync_pool_policy> {
+  static constexpr const char* name = "pmr sync pool";
+  static constexpr bool cross_thread = true;
+  explicit pmr_sync_pool_policy(std::size_t) {}
+  std::pmr::memory_resource* resource(std::size_t) { return &pool_; }
+  std::pmr::synchronized_pool_resource pool_;
+};
+
+struct pmr_unsync_pool_policy : pmr_policy_base<pmr_unsync_pool_policy> {
+  static constexpr const char* name = "pmr unsync pool";
+  static constexpr bool cross_thread = false;
+  explicit pmr_unsync_pool_policy(std::size_t threads) : pools_(threads) {}
+  std::pmr::memory_resource* resource(std::size_t thread) {
+    return &pools_[thread];
+  }
+  std::vector<std::pmr::unsynchronized_pool_resource> pools_;
+};
+#endif
+
+// Per-thread latency buffers, allocated before RSS is first read so that
+// they do not count towards RSS growth.
+using latency_buffers = std::vector<std::vector<std::uint32_t>>;
+
+// Returns operations per second.
+template <class Policy>
+double run_local(std::size_t threads, latency_buffers& latencies) {
+  Policy policy(threads);
+  start_barrier barrier(threads + 1);
+  std::vector<std::thread> workers;
+  for (std::size_t t = 0; t < threads; ++t) {
+    workers.emplace_back([&, t] {
+      auto& lat = latencies[t];
+      std::vector<typename Policy::value> originals;
+      std::vector<typename Policy::value> copies;
+      originals.reserve(batch);
+      copies.reserve(batch);
+      barrier.arrive_and_wait();
+      // Each round performs a create, a copy and two destroys per element.
+      for (std::size_t done = 0; done < ops_per_thread; done += 4 * batch) {
+        for (std::size_t i = 0; i < batch; ++i) {
+          const auto start = clock_type::now();
+          originals.push_back(policy.make(t));
+          lat.push_back(elapsed_ns(start));
+        }
+        for (std::size_t i = 0; i < batch; ++i) {
+          const auto start = clock_type::now();
+          copies.push_back(policy.copy(t, originals[i]));
+          lat.push_back(elapsed_ns(start));
+        }
+        do_not_optimize(copies.back());
+        for (auto* values : {&originals, &copies}) {
+          while (!values->empty()) {
+            const auto start = clock_type::now();
+            values->pop_back();
+            lat.push_back(elapsed_ns(start));
+          }
+        }
+      }
+    });
+  }
+  barrier.arrive_and_wait();
+  const auto start = clock_type::now();
+  for (auto& w : workers) w.join();
+  const double seconds =
+      std::chrono::duration<double>(clock_type::now() - start).count();
+  std::size_t ops = 0;
+  for (const auto& lat : latencies) ops += lat.size();
+  return static_cast<double>(ops) / seconds;
+}
+
+template <class Policy>
+double run_cross_thread(std::size_t threads, latency_buffers& latencies) {
+  const std::size_t pairs = threads / 2;
+  Policy policy(pairs);
+  start_barrier barrier(2 * pairs + 1);
+  std::vector<spsc_ring<typename Policy::value>> rings(pairs);
+  std::vector<std::thread> workers;
+  // Half of the operations are creates and half are destroys.
+  const std::size_t per_pair = ops_per_thread;
+  for (std::size_t p = 0; p < pairs; ++p) {
+    workers.emplace_back([&, p] {
+      auto& lat = latencies[2 * p];
+      barrier.arrive_and_wait();
+      for (std::size_t i = 0; i < per_pair; ++i) {
+        const auto start = clock_type::now();
+        auto v = policy.make(p);
+        lat.push_back(elapsed_ns(start));
+        while (!rings[p].try_push(v)) std::this_thread::yield();
+      }
+    });
+    workers.emplace_back([&, p] {
+      auto& lat = latencies[2 * p + 1];
+      barrier.arrive_and_wait();
+      std::optional<typename Policy::value> v;
+      for (std::size_t i = 0; i < per_pair; ++i) {
+        while (!rings[p].try_pop(v)) std::this_thread::yield();
+        const auto start = clock_type::now();
+        v.reset();
+        lat.push_back(elapsed_ns(start));
+      }
+    });
+  }
+  barrier.arrive_and_wait();
+  const auto start = clock_type::now();
+  for (auto& w : workers) w.join();
+  const double seconds =
+      std::chrono::duration<double>(clock_type::now() - start).count();
+  std::size_t ops = 0;
+  for (const auto& lat : latencies) ops += lat.size();
+  return static_cast<double>(ops) / seconds;
+}
+
+struct run_stats {
+  double ops_per_sec;
+  std::uint32_t p50;
+  std::uint32_t p99;
+  std::uint32_t p999;
+};
+
+template <class Run>
+void measure(const char* policy, const char* pattern, std::size_t threads,
+             Run run) {
+  // Filling the buffers faults their pages in before RSS is read.
+  latency_buffers latencies(threads,
+                            std::vector<std::uint32_t>(ops_per_thread));
+  std::vector<std::uint32_t> merged(threads * ops_per_thread);
+
+  const auto rss_before = resident_kib();
+  std::vector<run_stats> runs;
+  for (int r = 0; r < repetitions; ++r) {
+    for (auto& lat : latencies) lat.clear();
+    const double ops_per_sec = run(threads, latencies);
+    merged.clear();
+    for (const auto& lat : latencies) {
+      merged.insert(merged.end(), lat.begin(), lat.end());
+    }
+    std::sort(merged.begin(), merged.end());
+    const auto at = [&merged](double p) {
+      return merged[static_cast<std::size_t>(p * (merged.size() - 1))];
+    };
+    runs.push_back({ops_per_sec, at(0.5), at(0.99), at(0.999)});
+  }
+  const auto rss_after = resident_kib();
+
+  std::sort(runs.begin(), runs.end(), [](const auto& a, const auto& b) {
+    return a.ops_per_sec < b.ops_per_sec;
+  });
+  const run_stats& median = runs[runs.size() / 2];
+  std::printf("%-16s %-8s %7zu %10.2f %8u %8u %8u", policy, pattern, threads,
+              median.ops_per_sec / 1e6, median.p50, median.p99, median.p999);
+  if (rss_before && rss_after) {
+    std::printf(" %10ld\n", *rss_after - *rss_before);
+  } else {
+    std::printf(" %10s\n", "n/a");
+  }
+}
+
+template <class Policy>
+void run_policy(const std::vector<std::size_t>& thread_counts) {
+  for (std::size_t threads : thread_counts) {
+    measure(Policy::name, "local", threads, run_local<Policy>);
+  }
+  if constexpr (Policy::cross_thread) {
+    std::size_t previous = 0;
+    for (std::size_t threads : thread_counts) {
+      threads = std::max<std::size_t>(2, (threads + 1) / 2 * 2);
+      if (threads == previous) continue;
+      measure(Policy::name, "xthread", threads, run_cross_thread<Policy>);
+      previous = threads;
+    }
+  }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  std::size_t max_threads = std::max(1u, std::thread::hardware_concurrency());
+  if (argc > 1) max_threads = std::strtoul(argv[1], nullptr, 10);
+  std::vector<std::size_t> thread_counts;
+  for (std::size_t t = 1; t < max_threads; t *= 2) thread_counts.push_back(t);
+  thread_counts.push_back(max_threads);
+
+  std::printf("%zu operations per thread, median of %d runs\n\n",
+              ops_per_thread, repetitions);
+  std::printf("%-16s %-8s %7s %10s %8s %8s %8s %10s\n", "policy", "pattern",
+              "threads", "Mops/s", "p50 ns", "p99 ns", "p999 ns", "RSS KiB");
+
+  run_policy<default_policy>(thread_counts);
+  run_policy<std_allocator_policy>(thread_counts);
+#if defined(__cpp_lib_memory_resource)
+  run_policy<pmr_new_delete_policy>(thread_counts);
+  run_policy<pmr_sync_pool_policy>(thread_counts);
+  run_policy<pmr_unsync_pool_policy>(thread_counts);
+#endif
+}
@@ -0,0 +1,68 @@
+/* Copyright (c) 2019 The Indirect Value Authors. All Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+==============================================================================*/
+
+#ifndef ISOCPP_P1950_BENCHMARKS_BENCHMARK_H
+#define ISOCPP_P1950_BENCHMARKS_BENCHMARK_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+
+// Minimal timing helpers shared by the benchmark executables. The benchmarks
+// are plain programs so that they build without third-party dependencies.
+namespace isocpp_p1950::benchmark {
+
+// Prevents the compiler from discarding a computed value.
+template <class T>
+inline void do_not_optimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+  asm volatile("" : : "r,m"(value) : "memory");
+#else
+  static volatile const void* sink;
+  sink = &value;
+#endif
+}
+
+// Runs `f(iterations)` `repetitions` times and returns the fastest run in
+// nanoseconds per iteration. Taking the minimum filters out interference from
+// the rest of the system.
+template <class F>
+double ns_per_op(std::size_t iterations, F&& f, int repetitions = 5) {
+  double best = 0;
+  for (int r = 0; r < repetitions; ++r) {
+    const auto start = std::chrono::steady_clock::now();
+    f(iterations);
+    const auto stop = std::chrono::steady_clock::now();
+    const double ns =
+        std::chrono::duration<double, std::nano>(stop - start).count() /
+        static_cast<double>(iterations);
+    best = r == 0 ? ns : std::min(best, ns);
+  }
+  return best;
+}
+
+inline void report(const char* name, double ns) {
+  std::printf("%-48s %10.2f ns/op\n", name, ns);
+}
+
+}  // namespace isocpp_p1950::benchmark
+
+#endif  // ISOCPP_P1950_BENCHMARKS_BENCHMARK_H
@@ -0,0 +1,118 @@
+/* Copyright (c) 2019 The Indirect Value Authors. All Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+==============================================================================*/
+
+// Compares element-by-element equality and hashing of vector<indirect_value<T>>
+// with ranges_equal and hash_range from indirect_value_algorithm.h, for a
+// bytewise comparable record with pointees shuffled across the heap: the diff
+// and dedup workloads.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <vector>
+
+#include "benchmark.h"
+#include "indirect_value.h"
+#include "indirect_value_algorithm.h"
+
+using isocpp_p1950::indirect_value;
+using isocpp_p1950::benchmark::do_not_optimize;
+using isocpp_p1950::benchmark::ns_per_op;
+using isocpp_p1950::benchmark::report;
+
+struct record {
+  std::uint64_t id;
+  std::uint64_t parent;
+  std::uint64_t offset;
+  std::uint64_t length;
+
+  friend bool operator==(const record& a, const record& b) {
+    return a.id == b.id && a.parent == b.parent && a.offset == b.offset &&
+           a.length == b.length;
+  }
+};
+
+template <>
+struct isocpp_p1950::is_bytewise_comparable<record> : std::true_type {};
+
+std::vector<indirect_value<record>> make_records(std::size_t n) {
+  std::vector<indirect_value<record>> values;
+  values.reserve(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    values.emplace_back(new record{i, i / 2, i * 64, 64});
+  }
+  std::shuffle(values.begin(), values.end(), std::mt19937_64(42));
+  return values;
+}
+
+std::size_t naive_hash(const std::vector<indirect_value<record>>& values) {
+  std::size_t seed = values.size();
+  for (const auto& v : values) {
+    std::size_t h = 0;
+    if (v) {
+      h = std::hash<std::uint64_t>{}(v->id);
+      h = h * 31 + std::hash<std::uint64_t>{}(v->parent);
+      h = h * 31 + std::hash<std::uint64_t>{}(v->offset);
+      h = h * 31 + std::hash<std::uint64_t>{}(v->length);
+    }
+    seed ^= h + 0x9e3779b9u + (seed << 6) + (seed >> 2);
+  }
+  return seed;
+}
+
+void run(std::size_t n) {
+  const auto a = make_records(n);
+  const auto b = a;
+  const std::size_t iterations = std::max<std::size_t>(1, (1u << 22) / n);
+  char name[128];
+
+  std::snprintf(name, sizeof(name), "record n=%zu naive equal", n);
+  report(name, ns_per_op(iterations, [&](std::size_t k) {
+           for (std::size_t i = 0; i < k; ++i) do_not_optimize(a == b);
+         }) / static_cast<double>(n));
+
+  std::snprintf(name, sizeof(name), "record n=%zu ranges_equal", n);
+  report(name, ns_per_op(iterations, [&](std::size_t k) {
+           for (std::size_t i = 0; i < k; ++i) {
+             do_not_optimize(isocpp_p1950::ranges_equal(a, b));
+           }
+         }) / static_cast<double>(n));
+
+  std::snprintf(name, sizeof(name), "record n=%zu naive hash", n);
+  report(name, ns_per_op(iterations, [&](std::size_t k) {
+           for (std::size_t i = 0; i < k; ++i) do_not_optimize(naive_hash(a));
+         }) / static_cast<double>(n));
+
+  std::snprintf(name, sizeof(name), "record n=%zu hash_range", n);
+  report(name, ns_per_op(iterations, [&](std::size_t k) {
+           for (std::size_t i = 0; i < k; ++i) {
+             do_not_optimize(isocpp_p1950::hash_range(a));
+           }
+         }) / static_cast<double>(n));
+}
+
+int main() {
+  std::printf("Timings are per element.\n");
+  for (const std::size_t n : {std::size_t{1} << 10, std::size_t{1} << 20}) {
+    run(n);
+  }
+}
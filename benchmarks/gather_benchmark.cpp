@@ -0,0 +1,103 @@
+/* Copyright (c) 2019 The Indirect Value Authors. All Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+==============================================================================*/
+
+// Compares a naive element-by-element loop over vector<indirect_value<T>> with
+// the gather-based reductions in indirect_value_algorithm.h, for pointees laid
+// out in allocation order and for pointees shuffled across the heap.
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "benchmark.h"
+#include "indirect_value.h"
+#include "indirect_value_algorithm.h"
+
+using isocpp_p1950::indirect_value;
+using isocpp_p1950::benchmark::do_not_optimize;
+using isocpp_p1950::benchmark::ns_per_op;
+using isocpp_p1950::benchmark::report;
+
+template <class T>
+std::vector<indirect_value<T>> make_values(std::size_t n, bool shuffled) {
+  std::vector<indirect_value<T>> values;
+  values.reserve(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    values.emplace_back(new T(static_cast<T>(i % 1000)));
+  }
+  if (shuffled) {
+    std::shuffle(values.begin(), values.end(), std::mt19937_64(42));
+  }
+  return values;
+}
+
+template <class T>
+void run(const char* type, std::size_t n, bool shuffled) {
+  const auto values = make_values<T>(n, shuffled);
+  const std::size_t iterations = std::max<std::size_t>(1, (1u << 24) / n);
+  const char* layout = shuffled ? "shuffled" : "sequential";
+  char name[128];
+
+  std::snprintf(name, sizeof(name), "%s n=%zu %s naive sum", type, n, layout);
+  report(name, ns_per_op(iterations, [&values](std::size_t k) {
+           for (std::size_t i = 0; i < k; ++i) {
+             T total = T();
+             for (const auto& v : values) total += v ? *v : T();
+             do_not_optimize(total);
+           }
+         }) / static_cast<double>(n));
+
+  std::snprintf(name, sizeof(name), "%s n=%zu %s gather sum", type, n, layout);
+  report(name, ns_per_op(iterations, [&values](std::size_t k) {
+           for (std::size_t i = 0; i < k; ++i) {
+             do_not_optimize(isocpp_p1950::sum(values));
+           }
+         }) / static_cast<double>(n));
+
+  std::snprintf(name, sizeof(name), "%s n=%zu %s naive max", type, n, layout);
+  report(name, ns_per_op(iterations, [&values](std::size_t k) {
+           for (std::size_t i = 0; i < k; ++i) {
+             T result = *values.front();
+             for (const auto& v : values) {
+               const T x = v ? *v : T();
+               result = result < x ? x : result;
+             }
+             do_not_optimize(result);
+           }
+         }) / static_cast<double>(n));
+
+  std::snprintf(name, sizeof(name), "%s n=%zu %s gather max", type, n, layout);
+  report(name, ns_per_op(iterations, [&values](std::size_t k) {
+           for (std::size_t i = 0; i < k; ++i) {
+             do_not_optimize(isocpp_p1950::max(values));
+           }
+         }) / static_cast<double>(n));
+}
+
+int main() {
+  std::printf("Timings are per element.\n");
+  for (const std::size_t n : {std::size_t{1} << 10, std::size_t{1} << 20}) {
+    for (const bool shuffled : {false, true}) {
+      run<double>("double", n, shuffled);
+      run<float>("float", n, shuffled);
+    }
+  }
+}
@@ -0,0 +1,209 @@
+/* Copyright (c) 2019 The Indirect Value Authors. All Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+==============================================================================*/
+
+// Measures the hot-cold splitting example from p1950: a find_if over the
+// frequently accessed part of each Element, with the large, infrequently
+// accessed part stored either inline or behind an indirect_value.
+//
+// Each configuration is run for three access patterns:
+//   hot-only   the find_if from the paper; only SmallData is read.
+//   cold-1/16  every sixteenth element also reads its LargeData.
+//   cold-all   every element reads its LargeData.
+// Splitting is expected to pay off for hot-only scans once the inline
+// elements no longer fit in cache, and to hurt when the cold data is read
+// anyway because of the extra pointer chase.
+//
+// Cache-miss counts come from perf_event_open where permitted; "bytes" is
+// the last-level-cache misses multiplied by a 64-byte line.
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "benchmark.h"
+#include "indirect_value.h"
+#include "perf_counters.h"
+
+using isocpp_p1950::indirect_value;
+using isocpp_p1950::make_indirect_value;
+using isocpp_p1950::benchmark::do_not_optimize;
+using isocpp_p1950::benchmark::ns_per_op;
+using isocpp_p1950::benchmark::perf_counters;
+
+namespace {
+
+constexpr std::size_t cache_line = 64;
+constexpr std::size_t max_footprint = std::size_t{256} << 20;
+constexpr std::size_t visits_per_measurement = std::size_t{1} << 23;
+
+struct SmallData {
+  std::uint32_t key = 0;
+  bool active_flag = false;
+  bool active() const { return active_flag; }
+};
+
+template <std::size_t N>
+struct LargeData {
+  std::array<unsigned char, N> bytes{};
+};
+
+template <std::size_t N>
+struct InlineElement {
+  static constexpr std::size_t cold_size = N;
+  SmallData frequently_accessed_data;
+  LargeData<N> infrequently_accessed_data;
+
+  const LargeData<N>& cold() const { return infrequently_accessed_data; }
+};
+
+template <std::size_t N>
+struct SplitElement {
+  static constexpr std::size_t cold_size = N;
+  SmallData frequently_accessed_data;
+  indirect_value<LargeData<N>> infrequently_accessed_data =
+      make_indirect_value<LargeData<N>>();
+
+  const LargeData<N>& cold() const { return *infrequently_accessed_data; }
+};
+
+enum class pattern { hot_only, cold_sparse, cold_all };
+
+const char* name(pattern p) {
+  switch (p) {
+    case pattern::hot_only:
+      return "hot-only";
+    case pattern::cold_sparse:
+      return "cold-1/16";
+    case pattern::cold_all:
+      return "cold-all";
+  }
+  return "";
+}
+
+template <class Element>
+std::size_t scan(const std::vector<Element>& elements, pattern p) {
+  if (p == pattern::hot_only) {
+    auto active = std::find_if(
+        elements.begin(), elements.end(),
+        [](const auto& e) { return e.frequently_accessed_data.active(); });
+    return static_cast<std::size_t>(active - elements.begin());
+  }
+  // Strides and the byte index are powers of two so that masking, rather
+  // than division, selects the elements and bytes to read.
+  const std::size_t stride_mask = p == pattern::cold_all ? 0 : 15;
+  constexpr std::size_t byte_mask =
+      std::min(cache_line, Element::cold_size) - 1;
+  std::size_t sum = 0;
+  for (std::size_t i = 0; i < elements.size(); ++i) {
+    sum += elements[i].frequently_accessed_data.key;
+    if ((i & stride_mask) == 0) {
+      sum += elements[i].cold().bytes[i & byte_mask];
+    }
+  }
+  return sum;
+}
+
+struct measurement {
+  double ns_per_element;
+  perf_counters::sample counters;
+};
+
+template <class Element>
+measurement measure(std::size_t count, pattern p, perf_counters& counters) {
+  std::vector<Element> elements(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    elements[i].frequently_accessed_data.key = static_cast<std::uint32_t>(i);
+  }
+  elements.back().frequently_accessed_data.active_flag = true;
+
+  const std::size_t scans =
+      std::max<std::size_t>(1, visits_per_measurement / count);
+  const double ns = ns_per_op(scans, [&](std::size_t n) {
+    for (std::size_t i = 0; i < n; ++i) do_not_optimize(scan(elements, p));
+  });
+
+  counters.start();
+  do_not_optimize(scan(elements, p));
+  return {ns / static_cast<double>(count), counters.stop()};
+}
+
+void print_counter(const std::optional<std::uint64_t>& c, std::size_t count,
+                   std::size_t scale = 1) {
+  if (c) {
+    std::printf(" %12.3f",
+                static_cast<double>(*c * scale) / static_cast<double>(count));
+  } else {
+    std::printf(" %12s", "n/a");
+  }
+}
+
+void print_row(std::size_t count, std::size_t cold, pattern p,
+               const char* layout, const measurement& m) {
+  std::printf("%10zu %6zu %-10s %-7s %9.3f", count, cold, name(p), layout,
+              m.ns_per_element);
+  print_counter(m.counters.l1d_read_misses, count);
+  print_counter(m.counters.llc_misses, count);
+  print_counter(m.counters.llc_misses, count, cache_line);
+  std::printf("\n");
+}
+
+template <std::size_t ColdSize>
+void run_cold_size(perf_counters& counters) {
+  for (std::size_t count : {std::size_t{1} << 10, std::size_t{1} << 14,
+                            std::size_t{1} << 17, std::size_t{1} << 20}) {
+    if (count * sizeof(InlineElement<ColdSize>) > max_footprint) continue;
+    for (pattern p :
+         {pattern::hot_only, pattern::cold_sparse, pattern::cold_all}) {
+      const auto inline_m =
+          measure<InlineElement<ColdSize>>(count, p, counters);
+      const auto split_m = measure<SplitElement<ColdSize>>(count, p, counters);
+      print_row(count, ColdSize, p, "inline", inline_m);
+      print_row(count, ColdSize, p, "split", split_m);
+
+      const double ratio = split_m.ns_per_element / inline_m.ns_per_element;
+      const char* verdict = ratio < 0.95   ? "split pays off"
+                            : ratio > 1.05 ? "split hurts"
+                                           : "no significant difference";
+      std::printf("%10s %6s %-10s split/inline = %.2fx: %s\n\n", "", "", "",
+                  ratio, verdict);
+    }
+  }
+}
+
+}  // namespace
+
+int main() {
+  perf_counters counters;
+  if (!counters.available()) {
+    std::printf(
+        "Hardware counters are unavailable (perf_event_open failed); "
+        "reporting timings only.\n\n");
+  }
+  std::printf("%10s %6s %-10s %-7s %9s %12s %12s %12s\n", "elements", "cold",
+              "pattern", "layout", "ns/elem", "L1D-miss/el", "LLC-miss/el",
+              "bytes/elem");
+  run_cold_size<32>(counters);
+  run_cold_size<128>(counters);
+  run_cold_size<512>(counters);
+  run_cold_size<2048>(counters);
+}
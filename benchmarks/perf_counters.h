@@ -0,0 +1,123 @@
+/* Copyright (c) 2019 The Indirect Value Authors. All Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+==============================================================================*/
+
+#ifndef ISOCPP_P1950_BENCHMARKS_PERF_COUNTERS_H
+#define ISOCPP_P1950_BENCHMARKS_PERF_COUNTERS_H
+
+#include <cstdint>
+#include <optional>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cstring>
+#endif
+
+namespace isocpp_p1950::benchmark {
+
+// Hardware cache counters read through Linux perf_event_open.
+//
+// Counters are frequently unavailable: on other platforms, inside containers
+// and virtual machines, or when /proc/sys/kernel/perf_event_paranoid forbids
+// it. Each counter is opened independently and reports std::nullopt when it
+// cannot be read, so callers can print partial results.
+class perf_counters {
+ public:
+  struct sample {
+    std::optional<std::uint64_t> l1d_read_misses;
+    std::optional<std::uint64_t> llc_misses;
+  };
+
+  perf_counters() {
+#if defined(__linux__)
+    l1d_fd_ = open_counter(PERF_TYPE_HW_CACHE,
+                           PERF_COUNT_HW_CACHE_L1D |
+                               (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                               (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+    llc_fd_ = open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+#endif
+  }
+
+  perf_counters(const perf_counters&) = delete;
+  perf_counters& operator=(const perf_counters&) = delete;
+
+  ~perf_counters() {
+#if defined(__linux__)
+    if (l1d_fd_ >= 0) close(l1d_fd_);
+    if (llc_fd_ >= 0) close(llc_fd_);
+#endif
+  }
+
+  bool available() const noexcept { return l1d_fd_ >= 0 || llc_fd_ >= 0; }
+
+  void start() noexcept {
+#if defined(__linux__)
+    for (int fd : {l1d_fd_, llc_fd_}) {
+      if (fd >= 0) {
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+      }
+    }
+#endif
+  }
+
+  sample stop() noexcept {
+    sample s;
+#if defined(__linux__)
+    s.l1d_read_misses = read_counter(l1d_fd_);
+    s.llc_misses = read_counter(llc_fd_);
+#endif
+    return s;
+  }
+
+ private:
+#if defined(__linux__)
+  static int open_counter(std::uint32_t type, std::uint64_t config) noexcept {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return static_cast<int>(
+        syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+  }
+
+  static std::optional<std::uint64_t> read_counter(int fd) noexcept {
+    if (fd < 0) return std::nullopt;
+    ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+    std::uint64_t value = 0;
+    if (read(fd, &value, sizeof(value)) != sizeof(value)) return std::nullopt;
+    return value;
+  }
+#endif
+
+  int l1d_fd_ = -1;
+  int llc_fd_ = -1;
+};
+
+}  // namespace isocpp_p1950::benchmark
+
+#endif  // ISOCPP_P1950_BENCHMARKS_PERF_COUNTERS_H
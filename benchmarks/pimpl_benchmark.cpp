@@ -0,0 +1,92 @@
+/* Copyright (c) 2019 The Indirect Value Authors. All Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+==============================================================================*/
+
+// Compares the heap-allocating PImpl (example_pimpl, indirect_value) with the
+// inline-storage PImpl (example_fast_pimpl, fast_pimpl).
+
+#include <cstdio>
+#include <utility>
+#include <vector>
+
+#include "benchmark.h"
+#include "pimpl.h"
+
+using isocpp_p1950::benchmark::do_not_optimize;
+using isocpp_p1950::benchmark::ns_per_op;
+using isocpp_p1950::benchmark::report;
+
+template <class Pimpl>
+void run(const char* label) {
+  constexpr std::size_t iterations = 1'000'000;
+  char name[128];
+
+  std::snprintf(name, sizeof(name), "%s construct+destroy", label);
+  report(name, ns_per_op(iterations, [](std::size_t n) {
+           for (std::size_t i = 0; i < n; ++i) {
+             Pimpl p("a name");
+             do_not_optimize(p);
+           }
+         }));
+
+  const Pimpl source("a name");
+  std::snprintf(name, sizeof(name), "%s copy construct", label);
+  report(name, ns_per_op(iterations, [&source](std::size_t n) {
+           for (std::size_t i = 0; i < n; ++i) {
+             Pimpl p(source);
+             do_not_optimize(p);
+           }
+         }));
+
+  std::snprintf(name, sizeof(name), "%s copy assign", label);
+  report(name, ns_per_op(iterations, [&source](std::size_t n) {
+           Pimpl p;
+           for (std::size_t i = 0; i < n; ++i) {
+             p = source;
+             do_not_optimize(p);
+           }
+         }));
+
+  std::snprintf(name, sizeof(name), "%s move construct", label);
+  report(name, ns_per_op(iterations, [](std::size_t n) {
+           Pimpl p("a name");
+           for (std::size_t i = 0; i < n; ++i) {
+             Pimpl q(std::move(p));
+             p = std::move(q);
+             do_not_optimize(p);
+           }
+         }));
+
+  std::snprintf(name, sizeof(name), "%s vector<>(1000) copy", label);
+  const std::vector<Pimpl> many(1000, source);
+  report(name, ns_per_op(iterations / 1000, [&many](std::size_t n) {
+           for (std::size_t i = 0; i < n; ++i) {
+             std::vector<Pimpl> copy(many);
+             do_not_optimize(copy);
+           }
+         }));
+}
+
+int main() {
+  std::printf("sizeof(example_pimpl)      = %zu\n", sizeof(example_pimpl));
+  std::printf("sizeof(example_fast_pimpl) = %zu\n\n",
+              sizeof(example_fast_pimpl));
+  run<example_pimpl>("indirect_value");
+  run<example_fast_pimpl>("fast_pimpl");
+}
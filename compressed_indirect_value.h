@@ -0,0 +1,516 @@
+/* Copyright (c) 2019 The Indirect Value Authors. All Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+==============================================================================*/
+
+#ifndef ISOCPP_P1950_COMPRESSED_INDIRECT_VALUE_H
+#define ISOCPP_P1950_COMPRESSED_INDIRECT_VALUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "indirect_value.h"
+
+namespace isocpp_p1950 {
+
+// A dependency-free byte-oriented LZ77 codec in the style of LZ4.
+//
+// The output is a sequence of tokens. The high nibble of a token is the
+// number of literal bytes that follow it and the low nibble is the length of
+// the match after them, less four; a nibble of 15 is extended by following
+// bytes, each added to it, until one is not 255. Each match is followed by
+// its two-byte little-endian offset back into the output. The last token
+// carries literals only. Matches are found through a hash table of four-byte
+// sequences, so compression is a single pass over the input.
+//
+// A codec for compressed_indirect_value provides the same two members:
+// compress appends the encoding of [in, in + n) to out, and decompress
+// writes exactly out_size bytes to out and returns false if the input is not
+// a valid encoding of that many bytes.
+struct lz_codec {
+  void compress(const unsigned char* in, std::size_t n,
+                std::vector<unsigned char>& out) const {
+    constexpr int hash_bits = 12;
+    std::uint32_t table[1 << hash_bits] = {};
+    std::size_t anchor = 0;
+    std::size_t i = 0;
+    while (i + min_match <= n) {
+      const std::uint32_t sequence = load32(in + i);
+      const std::uint32_t h = (sequence * 2654435761u) >> (32 - hash_bits);
+      // Table entries are positions plus one, so that zero means unused.
+      const std::size_t candidate = table[h];
+      table[h] = static_cast<std::uint32_t>(i + 1);
+      if (candidate == 0 || i + 1 - candidate > max_offset ||
+          load32(in + candidate - 1) != sequence) {
+        ++i;
+        continue;
+      }
+      const std::size_t match = candidate - 1;
+      std::size_t length = min_match;
+      while (i + length < n && in[match + length] == in[i + length]) {
+        ++length;
+      }
+      emit(in + anchor, i - anchor, i - match, length, out);
+      i += length;
+      anchor = i;
+    }
+    emit(in + anchor, n - anchor, 0, 0, out);
+  }
+
+  bool decompress(const unsigned char* in, std::size_t n, unsigned char* out,
+                  std::size_t out_size) const {
+    const unsigned char* const end = in + n;
+    std::size_t op = 0;
+    while (in != end) {
+      const unsigned char token = *in++;
+      std::size_t literals = token >> 4;
+      if (literals == 15 && !read_length(in, end, literals)) return false;
+      if (literals > static_cast<std::size_t>(end - in) ||
+          literals > out_size - op) {
+        return false;
+      }
+      // An empty output may have no storage, which memcpy does not accept.
+      if (literals != 0) std::memcpy(out + op, in, literals);
+      in += literals;
+      op += literals;
+      if (op == out_size) return in == end;
+
+      if (end - in < 2) return false;
+      const std::size_t offset = in[0] | (std::size_t{in[1]} << 8);
+      in += 2;
+      std::size_t length = token & 15;
+      if (length == 15 && !read_length(in, end, length)) return false;
+      length += min_match;
+      if (offset == 0 || offset > op || length > out_size - op) return false;
+      const unsigned char* from = out + op - offset;
+      if (offset >= length) {
+        std::memcpy(out + op, from, length);
+      } else {
+        // The match overlaps the bytes it produces, so copy forwards.
+        for (std::size_t k = 0; k != length; ++k) out[op + k] = from[k];
+      }
+      op += length;
+    }
+    return false;
+  }
+
+ private:
+  static constexpr std::size_t min_match = 4;
+  static constexpr std::size_t max_offset = 65535;
+
+  static std::uint32_t load32(const unsigned char* p) noexcept {
+    std::uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+  }
+
+  static void write_length(std::size_t length,
+                           std::vector<unsigned char>& out) {
+    for (; length >= 255; length -= 255) out.push_back(255);
+    out.push_back(static_cast<unsigned char>(length));
+  }
+
+  static bool read_length(const unsigned char*& in, const unsigned char* end,
+                          std::size_t& length) noexcept {
+    unsigned char b;
+    do {
+      if (in == end) return false;
+      b = *in++;
+      length += b;
+    } while (b == 255);
+    return true;
+  }
+
+  // Appends a token for `literals` bytes from `from` followed, unless
+  // `length` is zero, by a match of `length` bytes at `offset`.
+  static void emit(const unsigned char* from, std::size_t literals,
+                   std::size_t offset, std::size_t length,
+                   std::vector<unsigned char>& out) {
+    const std::size_t match_code = length ? length - min_match : 0;
+    out.push_back(static_cast<unsigned char>(
+        ((literals < 15 ? literals : 15) << 4) |
+        (match_code < 15 ? match_code : 15)));
+    if (literals >= 15) write_length(literals - 15, out);
+    out.insert(out.end(), from, from + literals);
+    if (length == 0) return;
+    out.push_back(static_cast<unsigned char>(offset & 0xff));
+    out.push_back(static_cast<unsigned char>(offset >> 8));
+    if (match_code >= 15) write_length(match_code - 15, out);
+  }
+};
+
+// How compressed_indirect_value turns a T into bytes and back. The primary
+// template handles trivially copyable types by copying their object
+// representation; specialise it for other types with the same two members.
+template <class T>
+struct compression_traits {
+  static_assert(std::is_trivially_copyable_v<T>,
+                "specialise compression_traits for types that are not "
+                "trivially copyable");
+
+  static void serialize(const T& value, std::vector<unsigned char>& out) {
+    const auto* bytes = reinterpret_cast<const unsigned char*>(&value);
+    out.assign(bytes, bytes + sizeof(T));
+  }
+
+  static T deserialize(const unsigned char* data, std::size_t size) {
+    (void)size;
+    if constexpr (std::is_default_constructible_v<T>) {
+      T value;
+      std::memcpy(&value, data, sizeof(T));
+      return value;
+    } else {
+      alignas(T) unsigned char storage[sizeof(T)];
+      std::memcpy(storage, data, sizeof(T));
+      return *std::launder(reinterpret_cast<T*>(storage));
+    }
+  }
+};
+
+// Totals over every compressed_indirect_value of one type. The byte counts
+// cover the values currently alive; reads and writes count decompressions
+// and recompressions since the last reset. Compression pays off while the
+// bytes saved are worth more than the cost of `reads` decompressions.
+struct compression_statistics {
+  std::size_t values = 0;
+  std::size_t uncompressed_bytes = 0;
+  std::size_t compressed_bytes = 0;
+  std::size_t reads = 0;
+  std::size_t writes = 0;
+
+  std::size_t bytes_saved() const noexcept {
+    return uncompressed_bytes > compressed_bytes
+               ? uncompressed_bytes - compressed_bytes
+               : 0;
+  }
+
+  // Uncompressed size over compressed size, or 1 when nothing is stored.
+  double ratio() const noexcept {
+    return compressed_bytes ? static_cast<double>(uncompressed_bytes) /
+                                  static_cast<double>(compressed_bytes)
+                            : 1.0;
+  }
+};
+
+// A value-semantic owner of a T that is kept serialised and compressed, for
+// large and rarely read data.
+//
+// The value is only materialised inside an access guard. Dereferencing, on a
+// const or non-const object, returns a read guard holding a decompressed
+// copy, so `v->member` decompresses once for the full expression. write()
+// returns a guard with mutable access that recompresses the value when it is
+// committed or destroyed; until then reads of the same object see the old
+// value. Copying copies the compressed bytes without decompressing.
+//
+// Like indirect_value, a default constructed compressed_indirect_value is
+// empty.
+template <class T, class Codec = lz_codec>
+class ISOCPP_P1950_EMPTY_BASES compressed_indirect_value
+    : private indirect_value_copy_base<Codec> {
+  using codec_base = indirect_value_copy_base<Codec>;
+  using traits = compression_traits<T>;
+
+  std::unique_ptr<unsigned char[]> data_;
+  std::size_t compressed_size_ = 0;
+  std::size_t size_ = 0;
+  mutable std::atomic<std::uint32_t> accesses_{0};
+
+ public:
+  using value_type = T;
+  using codec_type = Codec;
+
+  class const_access_guard {
+   public:
+    const_access_guard(const const_access_guard&) = delete;
+    const_access_guard& operator=(const const_access_guard&) = delete;
+
+    const T& operator*() const noexcept { return value_; }
+    const T* operator->() const noexcept { return &value_; }
+
+   private:
+    friend class compressed_indirect_value;
+
+    explicit const_access_guard(const compressed_indirect_value& owner)
+        : value_(owner.load()) {}
+
+    T value_;
+  };
+
+  class access_guard {
+   public:
+    access_guard(const access_guard&) = delete;
+    access_guard& operator=(const access_guard&) = delete;
+
+    // Recompresses the value into the owner. Compression failures from
+    // the destructor terminate the program; call commit() to handle them.
+    ~access_guard() {
+      if (!committed_) owner_.store(value_);
+    }
+
+    // Mutable access after commit() makes the destructor store the value
+    // again. References kept from before commit() are not tracked.
+    T& operator*() noexcept {
+      committed_ = false;
+      return value_;
+    }
+    T* operator->() noexcept {
+      committed_ = false;
+      return &value_;
+    }
+
+    // Recompresses the value into the owner now; the guard stays usable.
+    void commit() {
+      owner_.store(value_);
+      committed_ = true;
+    }
+
+   private:
+    friend class compressed_indirect_value;
+
+    explicit access_guard(compressed_indirect_value& owner)
+        : owner_(owner), value_(owner.load()) {}
+
+    compressed_indirect_value& owner_;
+    T value_;
+    bool committed_ = false;
+  };
+
+  compressed_indirect_value() = default;
+
+  template <class... Ts>
+  explicit compressed_indirect_value(std::in_place_t, Ts&&... ts) {
+    store(T(std::forward<Ts>(ts)...));
+  }
+
+  explicit compressed_indirect_value(const T& value, Codec codec = Codec())
+      : codec_base(std::move(codec)) {
+    store(value);
+  }
+
+  compressed_indirect_value(const compressed_indirect_value& other)
+      : codec_base(other.get_codec()),
+        data_(other.data_ ? copy_bytes(other.data_.get(),
+                                       other.compressed_size_)
+                          : nullptr),
+        compressed_size_(other.compressed_size_),
+        size_(other.size_) {
+    count_value(+1);
+  }
+
+  compressed_indirect_value(compressed_indirect_value&& other) noexcept
+      : codec_base(std::move(other.get_codec())),
+        data_(std::move(other.data_)),
+        compressed_size_(std::exchange(other.compressed_size_, 0)),
+        size_(std::exchange(other.size_, 0)),
+        accesses_(other.accesses_.load(std::memory_order_relaxed)) {}
+
+  compressed_indirect_value& operator=(
+      const compressed_indirect_value& other) {
+    if (this != &other) compressed_indirect_value(other).swap(*this);
+    return *this;
+  }
+
+  compressed_indirect_value& operator=(
+      compressed_indirect_value&& other) noexcept {
+    if (this != &other) {
+      compressed_indirect_value(std::move(other)).swap(*this);
+    }
+    return *this;
+  }
+
+  ~compressed_indirect_value() { count_value(-1); }
+
+  const_access_guard operator*() const { return read(); }
+
+  const_access_guard operator->() const { return read(); }
+
+  // Decompresses the value into a guard giving const access. Requires a
+  // value.
+  const_access_guard read() const { return const_access_guard(*this); }
+
+  // Decompresses the value into a guard giving mutable access, which
+  // recompresses it when committed or destroyed. Requires a value.
+  access_guard write() { return access_guard(*this); }
+
+  // A decompressed copy of the value.
+  T value() const {
+    if (!data_) detail::handle_bad_access();
+    return load();
+  }
+
+  // Replaces the value, if any, with T(ts...).
+  template <class... Ts>
+  void emplace(Ts&&... ts) {
+    store(T(std::forward<Ts>(ts)...));
+  }
+
+  bool has_value() const noexcept { return data_ != nullptr; }
+
+  explicit operator bool() const noexcept { return data_ != nullptr; }
+
+  // The serialised size of the value and the size it is stored in.
+  std::size_t uncompressed_size() const noexcept { return size_; }
+
+  std::size_t compressed_size() const noexcept { return compressed_size_; }
+
+  // The number of times this value has been decompressed. A value that is
+  // read often is better stored uncompressed.
+  std::size_t accesses() const noexcept {
+    return accesses_.load(std::memory_order_relaxed);
+  }
+
+  codec_type& get_codec() noexcept { return codec_base::get(); }
+
+  const codec_type& get_codec() const noexcept { return codec_base::get(); }
+
+  void swap(compressed_indirect_value& other) noexcept(
+      std::is_nothrow_swappable_v<Codec>) {
+    using std::swap;
+    swap(get_codec(), other.get_codec());
+    swap(data_, other.data_);
+    swap(compressed_size_, other.compressed_size_);
+    swap(size_, other.size_);
+    const auto a = accesses_.load(std::memory_order_relaxed);
+    accesses_.store(other.accesses_.load(std::memory_order_relaxed),
+                    std::memory_order_relaxed);
+    other.accesses_.store(a, std::memory_order_relaxed);
+  }
+
+  template <class TC = Codec>
+  friend std::enable_if_t<std::is_swappable_v<TC>> swap(
+      compressed_indirect_value& lhs,
+      compressed_indirect_value& rhs) noexcept(noexcept(lhs.swap(rhs))) {
+    lhs.swap(rhs);
+  }
+
+  // Totals over every compressed_indirect_value<T, Codec>.
+  static compression_statistics statistics() noexcept {
+    auto& c = counters();
+    compression_statistics s;
+    s.values = c.values.load(std::memory_order_relaxed);
+    s.uncompressed_bytes = c.uncompressed_bytes.load(std::memory_order_relaxed);
+    s.compressed_bytes = c.compressed_bytes.load(std::memory_order_relaxed);
+    s.reads = c.reads.load(std::memory_order_relaxed);
+    s.writes = c.writes.load(std::memory_order_relaxed);
+    return s;
+  }
+
+  // Zeroes the read and write counts.
+  static void reset_statistics() noexcept {
+    counters().reads.store(0, std::memory_order_relaxed);
+    counters().writes.store(0, std::memory_order_relaxed);
+  }
+
+ private:
+  struct shared_counters {
+    std::atomic<std::size_t> values{0};
+    std::atomic<std::size_t> uncompressed_bytes{0};
+    std::atomic<std::size_t> compressed_bytes{0};
+    std::atomic<std::size_t> reads{0};
+    std::atomic<std::size_t> writes{0};
+  };
+
+  static shared_counters& counters() noexcept {
+    static shared_counters instance;
+    return instance;
+  }
+
+  // Adds (sign +1) or removes (sign -1) this value's bytes from the totals.
+  void count_value(int sign) const noexcept {
+    if (!data_) return;
+    auto& c = counters();
+    if (sign > 0) {
+      c.values.fetch_add(1, std::memory_order_relaxed);
+      c.uncompressed_bytes.fetch_add(size_, std::memory_order_relaxed);
+      c.compressed_bytes.fetch_add(compressed_size_,
+                                   std::memory_order_relaxed);
+    } else {
+      c.values.fetch_sub(1, std::memory_order_relaxed);
+      c.uncompressed_bytes.fetch_sub(size_, std::memory_order_relaxed);
+      c.compressed_bytes.fetch_sub(compressed_size_,
+                                   std::memory_order_relaxed);
+    }
+  }
+
+  static std::unique_ptr<unsigned char[]> copy_bytes(const unsigned char* p,
+                                                     std::size_t n) {
+    std::unique_ptr<unsigned char[]> copy(
+        detail::check_allocation(ISOCPP_P1950_NEW unsigned char[n]));
+    if (n != 0) std::memcpy(copy.get(), p, n);
+    return copy;
+  }
+
+  // Per-thread buffers reused across calls so that steady-state reads and
+  // writes only allocate the stored bytes.
+  static std::vector<unsigned char>& serialized_scratch() {
+    thread_local std::vector<unsigned char> buffer;
+    return buffer;
+  }
+
+  static std::vector<unsigned char>& compressed_scratch() {
+    thread_local std::vector<unsigned char> buffer;
+    return buffer;
+  }
+
+  void store(const T& value) {
+    auto& serialized = serialized_scratch();
+    auto& compressed = compressed_scratch();
+    serialized.clear();
+    compressed.clear();
+    traits::serialize(value, serialized);
+    get_codec().compress(serialized.data(), serialized.size(), compressed);
+    auto bytes = copy_bytes(compressed.data(), compressed.size());
+    count_value(-1);
+    data_ = std::move(bytes);
+    compressed_size_ = compressed.size();
+    size_ = serialized.size();
+    count_value(+1);
+    counters().writes.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  T load() const {
+    auto& serialized = serialized_scratch();
+    serialized.resize(size_);
+    // The bytes were produced by this codec, so a failure means they have
+    // been corrupted.
+    if (!get_codec().decompress(data_.get(), compressed_size_,
+                                serialized.data(), size_)) {
+      std::abort();
+    }
+    accesses_.fetch_add(1, std::memory_order_relaxed);
+    counters().reads.fetch_add(1, std::memory_order_relaxed);
+    return traits::deserialize(serialized.data(), size_);
+  }
+};
+
+template <class T, class... Ts>
+compressed_indirect_value<T> make_compressed_indirect_value(Ts&&... ts) {
+  return compressed_indirect_value<T>(std::in_place, std::forward<Ts>(ts)...);
+}
+
+}  // namespace isocpp_p1950
+
+#endif  // ISOCPP_P1950_COMPRESSED_INDIRECT_VALUE_H
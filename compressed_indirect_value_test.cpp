@@ -0,0 +1,324 @@
+/* Copyright (c) 2019 The Indirect Value Authors. All Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+==============================================================================*/
+
+#include "compressed_indirect_value.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "catch2/catch_test_macros.hpp"
+
+using isocpp_p1950::compressed_indirect_value;
+using isocpp_p1950::lz_codec;
+using isocpp_p1950::make_compressed_indirect_value;
+
+namespace {
+std::vector<unsigned char> round_trip(const std::vector<unsigned char>& in) {
+  std::vector<unsigned char> compressed;
+  lz_codec().compress(in.data(), in.size(), compressed);
+  std::vector<unsigned char> out(in.size());
+  REQUIRE(lz_codec().decompress(compressed.data(), compressed.size(),
+                                out.data(), out.size()));
+  return out;
+}
+
+struct LargeData {
+  std::array<std::uint32_t, 1024> counters{};
+  std::uint64_t id = 0;
+};
+
+struct Document {
+  std::string title;
+  std::string body;
+};
+
+// Stores the data uncompressed and counts the calls made through it.
+struct identity_codec {
+  int* compressions;
+
+  void compress(const unsigned char* in, std::size_t n,
+                std::vector<unsigned char>& out) const {
+    ++*compressions;
+    out.assign(in, in + n);
+  }
+
+  bool decompress(const unsigned char* in, std::size_t n, unsigned char* out,
+                  std::size_t out_size) const {
+    if (n != out_size) return false;
+    std::copy(in, in + n, out);
+    return true;
+  }
+};
+}  // namespace
+
+template <>
+struct isocpp_p1950::compression_traits<Document> {
+  static void serialize(const Document& d, std::vector<unsigned char>& out) {
+    const auto title = static_cast<std::uint32_t>(d.title.size());
+    out.resize(sizeof(title));
+    std::memcpy(out.data(), &title, sizeof(title));
+    out.insert(out.end(), d.title.begin(), d.title.end());
+    out.insert(out.end(), d.body.begin(), d.body.end());
+  }
+
+  static Document deserialize(const unsigned char* data, std::size_t size) {
+    std::uint32_t title;
+    std::memcpy(&title, data, sizeof(title));
+    const char* text = reinterpret_cast<const char*>(data + sizeof(title));
+    return Document{std::string(text, title),
+                    std::string(text + title, size - sizeof(title) - title)};
+  }
+};
+
+// Serialises a string as its characters alone, so an empty string has an
+// empty serialisation.
+template <>
+struct isocpp_p1950::compression_traits<std::string> {
+  static void serialize(const std::string& s, std::vector<unsigned char>& out) {
+    out.assign(s.begin(), s.end());
+  }
+
+  static std::string deserialize(const unsigned char* data, std::size_t size) {
+    return size == 0 ? std::string()
+                     : std::string(reinterpret_cast<const char*>(data), size);
+  }
+};
+
+TEST_CASE("lz_codec round trips its input", "[lz_codec.round_trip]") {
+  std::mt19937 random(7);
+  std::vector<std::vector<unsigned char>> inputs = {
+      {}, {1}, {1, 2, 3}, std::vector<unsigned char>(4, 9),
+      std::vector<unsigned char>(100000, 0)};
+  std::vector<unsigned char> noise(5000);
+  for (auto& b : noise) b = static_cast<unsigned char>(random());
+  inputs.push_back(noise);
+  std::vector<unsigned char> text;
+  for (int i = 0; i < 2000; ++i) {
+    const std::string word = "word" + std::to_string(i % 37) + " ";
+    text.insert(text.end(), word.begin(), word.end());
+  }
+  inputs.push_back(text);
+  std::vector<unsigned char> far(200000);
+  for (std::size_t i = 0; i < far.size(); ++i) {
+    far[i] = static_cast<unsigned char>(i < 70000 ? random() : far[i - 70000]);
+  }
+  inputs.push_back(far);
+
+  for (const auto& in : inputs) REQUIRE(round_trip(in) == in);
+}
+
+TEST_CASE("lz_codec compresses repetitive data", "[lz_codec.ratio]") {
+  std::vector<unsigned char> in(64 * 1024);
+  for (std::size_t i = 0; i < in.size(); ++i) {
+    in[i] = static_cast<unsigned char>(i % 200 < 100 ? 0 : i % 7);
+  }
+  std::vector<unsigned char> compressed;
+  lz_codec().compress(in.data(), in.size(), compressed);
+  REQUIRE(compressed.size() * 20 < in.size());
+}
+
+TEST_CASE("lz_codec rejects invalid input", "[lz_codec.invalid]") {
+  std::vector<unsigned char> in(1000);
+  for (std::size_t i = 0; i < in.size(); ++i) {
+    in[i] = static_cast<unsigned char>(i % 10);
+  }
+  std::vector<unsigned char> compressed;
+  lz_codec().compress(in.data(), in.size(), compressed);
+  std::vector<unsigned char> out(in.size());
+
+  REQUIRE(!lz_codec().decompress(compressed.data(), compressed.size() - 1,
+                                 out.data(), out.size()));
+  REQUIRE(!lz_codec().decompress(compressed.data(), compressed.size(),
+                                 out.data(), out.size() - 1));
+  const unsigned char offset_before_start[] = {0x10, 'a', 0x05, 0x00};
+  REQUIRE(!lz_codec().decompress(offset_before_start, 4, out.data(), 5));
+}
+
+TEST_CASE("compressed_indirect_value stores its value compressed",
+          "[compressed_indirect_value.construction]") {
+  GIVEN("A compressed_indirect_value of a large, sparse object") {
+    LargeData data;
+    data.counters[10] = 42;
+    data.id = 7;
+    compressed_indirect_value<LargeData> v(data);
+
+    THEN("It is stored in far fewer bytes") {
+      REQUIRE(v.has_value());
+      REQUIRE(v.uncompressed_size() == sizeof(LargeData));
+      REQUIRE(v.compressed_size() * 20 < sizeof(LargeData));
+    }
+    THEN("Access decompresses the value") {
+      REQUIRE(v->counters[10] == 42);
+      REQUIRE((*v)->id == 7);
+      REQUIRE(v.value().counters[11] == 0);
+      REQUIRE(v.accesses() == 3);
+    }
+  }
+  GIVEN("A default constructed compressed_indirect_value") {
+    compressed_indirect_value<LargeData> v;
+    THEN("It is empty") {
+      REQUIRE(!v);
+      REQUIRE(v.compressed_size() == 0);
+#ifndef ISOCPP_P1950_NO_EXCEPTIONS
+      REQUIRE_THROWS_AS(v.value(), isocpp_p1950::bad_indirect_value_access);
+#endif
+    }
+  }
+}
+
+TEST_CASE("Writes are recompressed when the guard is released",
+          "[compressed_indirect_value.write]") {
+  auto v = make_compressed_indirect_value<LargeData>();
+  const std::size_t empty_size = v.compressed_size();
+  GIVEN("A modification through a write guard") {
+    {
+      auto guard = v.write();
+      guard->counters[0] = 1;
+      REQUIRE(v->counters[0] == 0);
+    }
+    THEN("Later reads see it") { REQUIRE(v->counters[0] == 1); }
+  }
+  GIVEN("A committed write guard") {
+    auto guard = v.write();
+    for (std::size_t i = 0; i < guard->counters.size(); i += 3) {
+      guard->counters[i] = static_cast<std::uint32_t>(i * 2654435761u);
+    }
+    guard.commit();
+    THEN("The new value is stored immediately") {
+      REQUIRE(v->counters[3] == 3 * 2654435761u);
+      REQUIRE(v.compressed_size() > empty_size);
+    }
+  }
+  GIVEN("A write guard modified after it was committed") {
+    {
+      auto guard = v.write();
+      guard->id = 2;
+      guard.commit();
+      REQUIRE(v->id == 2);
+      guard->id = 3;
+    }
+    THEN("Its destructor stores the later modification") {
+      REQUIRE(v->id == 3);
+    }
+  }
+  GIVEN("A value replaced by emplace") {
+    LargeData data;
+    data.id = 99;
+    v.emplace(data);
+    REQUIRE(v->id == 99);
+  }
+}
+
+TEST_CASE("compressed_indirect_value copies are deep",
+          "[compressed_indirect_value.copy]") {
+  auto v = make_compressed_indirect_value<LargeData>();
+  v.write()->id = 1;
+  auto copy = v;
+  v.write()->id = 2;
+  REQUIRE(copy->id == 1);
+  REQUIRE(v->id == 2);
+
+  auto moved = std::move(copy);
+  REQUIRE(!copy);
+  REQUIRE(moved->id == 1);
+  copy = v;
+  REQUIRE(copy->id == 2);
+  swap(copy, moved);
+  REQUIRE(copy->id == 1);
+  REQUIRE(moved->id == 2);
+}
+
+TEST_CASE("Types that are not trivially copyable use compression_traits",
+          "[compressed_indirect_value.traits]") {
+  compressed_indirect_value<Document> doc(
+      Document{"title", std::string(10000, 'x') + "end"});
+  REQUIRE(doc->title == "title");
+  REQUIRE(doc->body.size() == 10003);
+  REQUIRE(doc.compressed_size() < 200);
+  doc.write()->title = "renamed";
+  REQUIRE(doc.value().title == "renamed");
+  REQUIRE(doc->body.substr(10000) == "end");
+}
+
+TEST_CASE("Empty and single-byte serialisations round trip",
+          "[compressed_indirect_value.small]") {
+  GIVEN("A value whose serialisation is empty") {
+    compressed_indirect_value<std::string> empty{std::string()};
+    REQUIRE(empty.value().empty());
+    THEN("Copies and rewrites round trip") {
+      auto copy = empty;
+      REQUIRE(copy.value().empty());
+      copy.write()->assign("x");
+      REQUIRE(copy.value() == "x");
+      copy.write()->clear();
+      REQUIRE(copy.value().empty());
+    }
+  }
+  GIVEN("A value whose serialisation is one byte") {
+    compressed_indirect_value<char> one('a');
+    REQUIRE(one.value() == 'a');
+    auto copy = one;
+    *copy.write() = 'b';
+    REQUIRE(copy.value() == 'b');
+    REQUIRE(one.value() == 'a');
+  }
+}
+
+TEST_CASE("A user-supplied codec is used for every write",
+          "[compressed_indirect_value.codec]") {
+  int compressions = 0;
+  compressed_indirect_value<std::uint64_t, identity_codec> v(
+      42, identity_codec{&compressions});
+  REQUIRE(compressions == 1);
+  REQUIRE(v.compressed_size() == sizeof(std::uint64_t));
+  *v.write() = 43;
+  REQUIRE(compressions == 2);
+  REQUIRE(*v.read() == 43);
+}
+
+TEST_CASE("Statistics report the savings and the accesses",
+          "[compressed_indirect_value.statistics]") {
+  using value = compressed_indirect_value<LargeData>;
+  value::reset_statistics();
+  const auto before = value::statistics();
+  {
+    std::vector<value> values(10, value(LargeData()));
+    for (const auto& v : values) (void)v->id;
+    values[0].write()->id = 1;
+
+    const auto s = value::statistics();
+    REQUIRE(s.values == before.values + 10);
+    REQUIRE(s.uncompressed_bytes ==
+            before.uncompressed_bytes + 10 * sizeof(LargeData));
+    REQUIRE(s.bytes_saved() > before.bytes_saved() + 9 * sizeof(LargeData));
+    REQUIRE(s.ratio() > 20);
+    REQUIRE(s.reads == 11);
+    REQUIRE(s.writes == 2);
+  }
+  const auto after = value::statistics();
+  REQUIRE(after.values == before.values);
+  REQUIRE(after.compressed_bytes == before.compressed_bytes);
+}
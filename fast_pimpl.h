@@ -0,0 +1,146 @@
+/* Copyright (c) 2019 The Indirect Value Authors. All Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+==============================================================================*/
+
+#ifndef ISOCPP_P1950_FAST_PIMPL_H
+#define ISOCPP_P1950_FAST_PIMPL_H
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace isocpp_p1950 {
+
+// Inline storage for a PImpl.
+//
+// Like indirect_value<Impl>, fast_pimpl deep copies, propagates const and
+// works with an Impl that is incomplete where the owning class is declared.
+// The Impl lives in a fixed buffer inside the owning object instead of on the
+// heap, so construction and copying never allocate.
+//
+// Size and Align are chosen in the header. Every member that constructs or
+// destroys the Impl checks at compile time that the buffer is large enough
+// and suitably aligned, so the owning class must define its special members
+// out of line, in the translation unit where Impl is complete.
+//
+// A moved-from fast_pimpl is empty, matching indirect_value.
+template <class Impl, std::size_t Size,
+          std::size_t Align = alignof(std::max_align_t)>
+class fast_pimpl {
+ public:
+  using value_type = Impl;
+
+  fast_pimpl() noexcept = default;
+
+  template <class... Ts>
+  explicit fast_pimpl(std::in_place_t, Ts&&... ts) {
+    emplace(std::forward<Ts>(ts)...);
+  }
+
+  fast_pimpl(const fast_pimpl& rhs) {
+    if (rhs.engaged_) emplace(*rhs);
+  }
+
+  fast_pimpl(fast_pimpl&& rhs) noexcept {
+    if (rhs.engaged_) {
+      emplace(std::move(*rhs));
+      rhs.reset();
+    }
+  }
+
+  fast_pimpl& operator=(const fast_pimpl& rhs) {
+    if (this != &rhs) {
+      // When copying Impl throws, *this will remain unchanged.
+      if (rhs.engaged_) {
+        Impl copy(*rhs);
+        reset();
+        emplace(std::move(copy));
+      } else {
+        reset();
+      }
+    }
+    return *this;
+  }
+
+  fast_pimpl& operator=(fast_pimpl&& rhs) noexcept {
+    if (this != &rhs) {
+      reset();
+      if (rhs.engaged_) {
+        emplace(std::move(*rhs));
+        rhs.reset();
+      }
+    }
+    return *this;
+  }
+
+  ~fast_pimpl() { reset(); }
+
+  Impl* operator->() noexcept { return get(); }
+
+  const Impl* operator->() const noexcept { return get(); }
+
+  Impl& operator*() noexcept { return *get(); }
+
+  const Impl& operator*() const noexcept { return *get(); }
+
+  explicit constexpr operator bool() const noexcept { return engaged_; }
+
+  constexpr bool has_value() const noexcept { return engaged_; }
+
+ private:
+  static constexpr void check_storage() noexcept {
+    static_assert(sizeof(Impl) <= Size,
+                  "fast_pimpl storage is too small for Impl; increase Size");
+    static_assert(Align % alignof(Impl) == 0,
+                  "fast_pimpl storage is insufficiently aligned for Impl");
+    static_assert(std::is_nothrow_move_constructible_v<Impl>,
+                  "fast_pimpl requires a nothrow move constructible Impl");
+  }
+
+  template <class... Ts>
+  void emplace(Ts&&... ts) {
+    check_storage();
+    ::new (static_cast<void*>(storage_)) Impl(std::forward<Ts>(ts)...);
+    engaged_ = true;
+  }
+
+  void reset() noexcept {
+    if (engaged_) {
+      check_storage();
+      engaged_ = false;
+      get()->~Impl();
+    }
+  }
+
+  Impl* get() noexcept {
+    return std::launder(reinterpret_cast<Impl*>(storage_));
+  }
+
+  const Impl* get() const noexcept {
+    return std::launder(reinterpret_cast<const Impl*>(storage_));
+  }
+
+  alignas(Align) unsigned char storage_[Size];
+  bool engaged_ = false;
+};
+
+}  // namespace isocpp_p1950
+
+#endif  // ISOCPP_P1950_FAST_PIMPL_H
@@ -0,0 +1,338 @@
+/* Copyright (c) 2019 The Indirect Value Authors. All Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+==============================================================================*/
+
+#ifndef ISOCPP_P1950_INDIRECT_TUPLE_H
+#define ISOCPP_P1950_INDIRECT_TUPLE_H
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "indirect_value.h"
+
+namespace isocpp_p1950 {
+
+namespace detail {
+
+// The layout of a block holding one object of each of Ts, in declaration
+// order, each at an offset suitably aligned for its type.
+template <class... Ts>
+struct tuple_block_layout {
+  static constexpr std::size_t count = sizeof...(Ts);
+
+  static constexpr std::size_t alignment = [] {
+    std::size_t a = 1;
+    for (std::size_t x : {alignof(Ts)...}) a = x > a ? x : a;
+    return a;
+  }();
+
+  static constexpr std::array<std::size_t, count + 1> offsets = [] {
+    constexpr std::size_t sizes[] = {sizeof(Ts)...};
+    constexpr std::size_t alignments[] = {alignof(Ts)...};
+    std::array<std::size_t, count + 1> result{};
+    std::size_t offset = 0;
+    for (std::size_t i = 0; i != count; ++i) {
+      offset = (offset + alignments[i] - 1) / alignments[i] * alignments[i];
+      result[i] = offset;
+      offset += sizes[i];
+    }
+    result[count] = offset;
+    return result;
+  }();
+
+  static constexpr std::size_t size = offsets[count];
+
+  static constexpr bool over_aligned =
+      alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+
+  static unsigned char* allocate() {
+    void* p;
+#ifdef ISOCPP_P1950_NO_EXCEPTIONS
+    if constexpr (over_aligned) {
+      p = ::operator new(size, std::align_val_t(alignment), std::nothrow);
+    } else {
+      p = ::operator new(size, std::nothrow);
+    }
+#else
+    if constexpr (over_aligned) {
+      p = ::operator new(size, std::align_val_t(alignment));
+    } else {
+      p = ::operator new(size);
+    }
+#endif
+    return static_cast<unsigned char*>(check_allocation(p));
+  }
+
+  static void deallocate(unsigned char* p) noexcept {
+    if constexpr (over_aligned) {
+      ::operator delete(p, size, std::align_val_t(alignment));
+    } else {
+      ::operator delete(p, size);
+    }
+  }
+};
+
+}  // namespace detail
+
+// A value-semantic owner of one object of each of Ts, all allocated in a
+// single block.
+//
+// indirect_tuple stands in for several indirect_value members of one class,
+// such as separately allocated hot and cold state: construction and copy make
+// one allocation instead of one per member, and the objects are adjacent in
+// memory. Like indirect_value, copies are deep and const propagates: get<I>()
+// on a const indirect_tuple returns a const reference.
+//
+// An indirect_tuple always holds all of its objects, except after it has been
+// moved from, when it holds none; only assignment, destruction and
+// valueless_after_move() may be used on a moved-from indirect_tuple.
+template <class... Ts>
+class indirect_tuple {
+  static_assert(sizeof...(Ts) > 0, "indirect_tuple must hold an object");
+  static_assert((... && (std::is_object_v<Ts> && !std::is_array_v<Ts>)),
+                "indirect_tuple elements must be non-array object types");
+
+  using layout = detail::tuple_block_layout<Ts...>;
+
+  template <std::size_t I>
+  using element_t = std::tuple_element_t<I, std::tuple<Ts...>>;
+
+  unsigned char* block_ = nullptr;
+
+ public:
+  template <class Dummy = void,
+            class = std::enable_if_t<
+                std::is_void_v<Dummy> &&
+                (... && std::is_default_constructible_v<Ts>)>>
+  indirect_tuple() {
+    construct([](auto, void* where, auto* type) {
+      using T = std::remove_pointer_t<decltype(type)>;
+      ::new (where) T();
+    });
+  }
+
+  // Constructs each object from the corresponding argument.
+  template <class... Us,
+            class = std::enable_if_t<
+                sizeof...(Us) == sizeof...(Ts) &&
+                (... && std::is_constructible_v<Ts, Us&&>)>>
+  explicit indirect_tuple(std::in_place_t, Us&&... us) {
+    auto args = std::forward_as_tuple(std::forward<Us>(us)...);
+    construct([&args](auto index, void* where, auto* type) {
+      using T = std::remove_pointer_t<decltype(type)>;
+      ::new (where) T(std::get<decltype(index)::value>(std::move(args)));
+    });
+  }
+
+  // Copies all of the objects into one new block.
+  indirect_tuple(const indirect_tuple& other) {
+    static_assert((... && std::is_copy_constructible_v<Ts>),
+                  "indirect_tuple copies require copyable elements");
+    if (other.block_ == nullptr) return;
+    construct([&other](auto index, void* where, auto* type) {
+      using T = std::remove_pointer_t<decltype(type)>;
+      ::new (where) T(other.template get<decltype(index)::value>());
+    });
+  }
+
+  indirect_tuple(indirect_tuple&& other) noexcept
+      : block_(std::exchange(other.block_, nullptr)) {}
+
+  // Gives the strong exception guarantee: the copy is made before the
+  // current objects are released.
+  indirect_tuple& operator=(const indirect_tuple& other) {
+    if (this != &other) indirect_tuple(other).swap(*this);
+    return *this;
+  }
+
+  indirect_tuple& operator=(indirect_tuple&& other) noexcept {
+    if (this != &other) {
+      reset();
+      block_ = std::exchange(other.block_, nullptr);
+    }
+    return *this;
+  }
+
+  ~indirect_tuple() { reset(); }
+
+  template <std::size_t I>
+  element_t<I>& get() & noexcept {
+    return *pointer<I>(block_);
+  }
+
+  template <std::size_t I>
+  const element_t<I>& get() const& noexcept {
+    return *pointer<I>(block_);
+  }
+
+  template <std::size_t I>
+  element_t<I>&& get() && noexcept {
+    return std::move(*pointer<I>(block_));
+  }
+
+  template <std::size_t I>
+  const element_t<I>&& get() const&& noexcept {
+    return std::move(*pointer<I>(block_));
+  }
+
+  // The object of type T, which must occur exactly once in Ts.
+  template <class T>
+  T& get() & noexcept {
+    static_assert(index_of<T>() != sizeof...(Ts),
+                  "T must occur exactly once in the indirect_tuple");
+    return *pointer<index_of<T>()>(block_);
+  }
+
+  template <class T>
+  const T& get() const& noexcept {
+    static_assert(index_of<T>() != sizeof...(Ts),
+                  "T must occur exactly once in the indirect_tuple");
+    return *pointer<index_of<T>()>(block_);
+  }
+
+  bool valueless_after_move() const noexcept { return block_ == nullptr; }
+
+  void swap(indirect_tuple& other) noexcept {
+    std::swap(block_, other.block_);
+  }
+
+  friend void swap(indirect_tuple& lhs, indirect_tuple& rhs) noexcept {
+    lhs.swap(rhs);
+  }
+
+ private:
+  template <std::size_t I>
+  static element_t<I>* pointer(unsigned char* block) noexcept {
+    return std::launder(
+        reinterpret_cast<element_t<I>*>(block + layout::offsets[I]));
+  }
+
+  template <std::size_t I>
+  static const element_t<I>* pointer(const unsigned char* block) noexcept {
+    return std::launder(
+        reinterpret_cast<const element_t<I>*>(block + layout::offsets[I]));
+  }
+
+  template <class T>
+  static constexpr std::size_t index_of() {
+    constexpr bool matches[] = {std::is_same_v<T, Ts>...};
+    std::size_t found = sizeof...(Ts);
+    std::size_t n = 0;
+    for (std::size_t i = 0; i != sizeof...(Ts); ++i) {
+      if (matches[i]) {
+        found = i;
+        ++n;
+      }
+    }
+    return n == 1 ? found : sizeof...(Ts);
+  }
+
+  // Allocates a block and calls f(integral_constant<I>, address, T*) to
+  // construct each object in order. If a construction throws, the objects
+  // already constructed are destroyed and the block is released.
+  template <class F>
+  void construct(F&& f) {
+    construct(f, std::index_sequence_for<Ts...>());
+  }
+
+  template <class F, std::size_t... I>
+  void construct(F& f, std::index_sequence<I...>) {
+    unsigned char* block = layout::allocate();
+    std::size_t constructed = 0;
+    ISOCPP_P1950_TRY {
+      (..., (f(std::integral_constant<std::size_t, I>(),
+               block + layout::offsets[I],
+               static_cast<element_t<I>*>(nullptr)),
+             ++constructed));
+    }
+    ISOCPP_P1950_CATCH_ALL {
+      destroy(block, constructed);
+      layout::deallocate(block);
+      ISOCPP_P1950_RETHROW;
+    }
+    block_ = block;
+  }
+
+  // Destroys the first n objects of the block, last first.
+  static void destroy(unsigned char* block, std::size_t n) noexcept {
+    destroy(block, n, std::index_sequence_for<Ts...>());
+  }
+
+  template <std::size_t... I>
+  static void destroy(unsigned char* block, std::size_t n,
+                      std::index_sequence<I...>) noexcept {
+    constexpr std::size_t last = sizeof...(Ts) - 1;
+    (..., (last - I < n ? std::destroy_at(pointer<last - I>(block))
+                        : void()));
+  }
+
+  void reset() noexcept {
+    if (block_ != nullptr) {
+      destroy(block_, sizeof...(Ts));
+      layout::deallocate(std::exchange(block_, nullptr));
+    }
+  }
+};
+
+template <class... Us>
+indirect_tuple(std::in_place_t, Us...) -> indirect_tuple<Us...>;
+
+template <std::size_t I, class... Ts>
+decltype(auto) get(indirect_tuple<Ts...>& t) noexcept {
+  return t.template get<I>();
+}
+
+template <std::size_t I, class... Ts>
+decltype(auto) get(const indirect_tuple<Ts...>& t) noexcept {
+  return t.template get<I>();
+}
+
+template <std::size_t I, class... Ts>
+decltype(auto) get(indirect_tuple<Ts...>&& t) noexcept {
+  return std::move(t).template get<I>();
+}
+
+template <class T, class... Ts>
+T& get(indirect_tuple<Ts...>& t) noexcept {
+  return t.template get<T>();
+}
+
+template <class T, class... Ts>
+const T& get(const indirect_tuple<Ts...>& t) noexcept {
+  return t.template get<T>();
+}
+
+}  // namespace isocpp_p1950
+
+namespace std {
+template <class... Ts>
+struct tuple_size<::isocpp_p1950::indirect_tuple<Ts...>>
+    : integral_constant<size_t, sizeof...(Ts)> {};
+
+template <size_t I, class... Ts>
+struct tuple_element<I, ::isocpp_p1950::indirect_tuple<Ts...>>
+    : tuple_element<I, tuple<Ts...>> {};
+}  // namespace std
+
+#endif  // ISOCPP_P1950_INDIRECT_TUPLE_H
@@ -0,0 +1,218 @@
+/* Copyright (c) 2019 The Indirect Value Authors. All Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+==============================================================================*/
+
+#include "indirect_tuple.h"
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include "catch2/catch_test_macros.hpp"
+
+using isocpp_p1950::indirect_tuple;
+
+namespace {
+struct Hot {
+  int key = 0;
+  bool active = false;
+};
+
+struct Cold {
+  std::string name;
+  double weights[4] = {};
+};
+
+struct alignas(64) Aligned {
+  unsigned char bytes[64] = {};
+};
+
+struct Counted {
+  Counted() { ++live; }
+  Counted(const Counted&) { ++live; }
+  ~Counted() { --live; }
+
+  inline static int live = 0;
+};
+}  // namespace
+
+TEST_CASE("indirect_tuple is a single pointer",
+          "[indirect_tuple.sizeof]") {
+  STATIC_REQUIRE(sizeof(indirect_tuple<Hot, Cold>) == sizeof(void*));
+  STATIC_REQUIRE(std::tuple_size_v<indirect_tuple<Hot, Cold, int>> == 3);
+  STATIC_REQUIRE(
+      std::is_same_v<std::tuple_element_t<1, indirect_tuple<Hot, Cold>>,
+                     Cold>);
+}
+
+TEST_CASE("indirect_tuple places its objects in one block",
+          "[indirect_tuple.layout]") {
+  indirect_tuple<char, Aligned, Hot, Cold> t;
+  const auto* first = reinterpret_cast<const unsigned char*>(&t.get<0>());
+  const auto* aligned = reinterpret_cast<const unsigned char*>(&t.get<1>());
+  const auto* hot = reinterpret_cast<const unsigned char*>(&t.get<2>());
+  const auto* cold = reinterpret_cast<const unsigned char*>(&t.get<3>());
+
+  REQUIRE(reinterpret_cast<std::uintptr_t>(aligned) % alignof(Aligned) == 0);
+  REQUIRE(reinterpret_cast<std::uintptr_t>(cold) % alignof(Cold) == 0);
+  REQUIRE(first < aligned);
+  REQUIRE(aligned < hot);
+  REQUIRE(hot < cold);
+}
+
+TEST_CASE("indirect_tuple construction and access",
+          "[indirect_tuple.constructors]") {
+  GIVEN("An indirect_tuple constructed in place") {
+    indirect_tuple t(std::in_place, Hot{7, true}, Cold{"cold", {1, 2, 3, 4}});
+    STATIC_REQUIRE(std::is_same_v<decltype(t), indirect_tuple<Hot, Cold>>);
+
+    THEN("Each object is constructed from its argument") {
+      REQUIRE(t.get<0>().key == 7);
+      REQUIRE(t.get<Hot>().active);
+      REQUIRE(t.get<1>().name == "cold");
+      REQUIRE(isocpp_p1950::get<Cold>(t).weights[3] == 4);
+    }
+    THEN("Access through a const indirect_tuple is const") {
+      const auto& c = t;
+      STATIC_REQUIRE(std::is_same_v<decltype(c.get<0>()), const Hot&>);
+      STATIC_REQUIRE(
+          std::is_same_v<decltype(isocpp_p1950::get<1>(c)), const Cold&>);
+      STATIC_REQUIRE(std::is_same_v<decltype(std::move(t).get<1>()), Cold&&>);
+    }
+    THEN("Structured bindings refer to the objects") {
+      auto& [hot, cold] = t;
+      hot.key = 8;
+      REQUIRE(t.get<Hot>().key == 8);
+      REQUIRE(&cold == &t.get<Cold>());
+    }
+  }
+}
+
+TEST_CASE("indirect_tuple copies are deep",
+          "[indirect_tuple.copy]") {
+  GIVEN("An indirect_tuple and a copy of it") {
+    indirect_tuple<Hot, Cold> t(std::in_place, Hot{1, false}, Cold{"a", {}});
+    indirect_tuple<Hot, Cold> copy(t);
+
+    THEN("The copy has equal objects at different addresses") {
+      REQUIRE(copy.get<Hot>().key == 1);
+      REQUIRE(copy.get<Cold>().name == "a");
+      REQUIRE(&copy.get<Hot>() != &t.get<Hot>());
+    }
+    WHEN("The original is modified") {
+      t.get<Cold>().name.assign(1, 'b');
+      THEN("The copy is unchanged") { REQUIRE(copy.get<Cold>().name == "a"); }
+    }
+    WHEN("The copy is assigned back") {
+      t.get<Hot>().key = 2;
+      copy = t;
+      THEN("It takes the new values") { REQUIRE(copy.get<Hot>().key == 2); }
+    }
+  }
+}
+
+TEST_CASE("indirect_tuple moves transfer the block",
+          "[indirect_tuple.move]") {
+  indirect_tuple<Hot, Cold> t(std::in_place, Hot{3, true}, Cold{"m", {}});
+  const Hot* address = &t.get<Hot>();
+
+  GIVEN("A move constructed indirect_tuple") {
+    indirect_tuple<Hot, Cold> moved(std::move(t));
+    THEN("It owns the original objects and the source is valueless") {
+      REQUIRE(&moved.get<Hot>() == address);
+      REQUIRE(t.valueless_after_move());
+      REQUIRE(!moved.valueless_after_move());
+    }
+    THEN("A copy of the valueless source is valueless") {
+      indirect_tuple<Hot, Cold> copy(t);
+      REQUIRE(copy.valueless_after_move());
+    }
+    THEN("The valueless source can be assigned to") {
+      t = moved;
+      REQUIRE(t.get<Cold>().name == "m");
+    }
+  }
+  GIVEN("A move assigned indirect_tuple") {
+    indirect_tuple<Hot, Cold> other;
+    other = std::move(t);
+    THEN("It owns the original objects") {
+      REQUIRE(&other.get<Hot>() == address);
+      REQUIRE(t.valueless_after_move());
+    }
+  }
+  GIVEN("Two swapped indirect_tuples") {
+    indirect_tuple<Hot, Cold> other;
+    swap(t, other);
+    THEN("The blocks are exchanged") {
+      REQUIRE(&other.get<Hot>() == address);
+      REQUIRE(t.get<Hot>().key == 0);
+    }
+  }
+}
+
+TEST_CASE("indirect_tuple destroys every object",
+          "[indirect_tuple.destructor]") {
+  Counted::live = 0;
+  {
+    indirect_tuple<Counted, Hot, Counted> t;
+    REQUIRE(Counted::live == 2);
+    indirect_tuple<Counted, Hot, Counted> copy(t);
+    REQUIRE(Counted::live == 4);
+    copy = std::move(t);
+    REQUIRE(Counted::live == 2);
+  }
+  REQUIRE(Counted::live == 0);
+}
+
+#ifndef ISOCPP_P1950_NO_EXCEPTIONS
+namespace {
+struct ThrowsOnCopy {
+  ThrowsOnCopy() { ++live; }
+  ThrowsOnCopy(const ThrowsOnCopy&) {
+    if (throw_next) throw std::runtime_error("copy");
+    ++live;
+  }
+  ~ThrowsOnCopy() { --live; }
+
+  inline static bool throw_next = false;
+  inline static int live = 0;
+};
+}  // namespace
+
+TEST_CASE("A throwing copy leaves no objects behind",
+          "[indirect_tuple.exceptions]") {
+  Counted::live = 0;
+  ThrowsOnCopy::live = 0;
+  {
+    indirect_tuple<Counted, ThrowsOnCopy, Counted> t;
+    ThrowsOnCopy::throw_next = true;
+    REQUIRE_THROWS_AS((indirect_tuple<Counted, ThrowsOnCopy, Counted>(t)),
+                      std::runtime_error);
+    indirect_tuple<Counted, ThrowsOnCopy, Counted> target;
+    REQUIRE_THROWS_AS(target = t, std::runtime_error);
+    ThrowsOnCopy::throw_next = false;
+    REQUIRE(Counted::live == 4);
+    REQUIRE(ThrowsOnCopy::live == 2);
+  }
+  REQUIRE(Counted::live == 0);
+  REQUIRE(ThrowsOnCopy::live == 0);
+}
+#endif
@@ -0,0 +1,57 @@
+/* Copyright (c) 2019 The Indirect Value Authors. All Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+==============================================================================*/
+
+// The isocpp_p1950.indirect_value module.
+//
+// indirect_value.h is included in the global module fragment and its public
+// names are re-exported, so entities reached through `import` and through
+// `#include "indirect_value.h"` are the same and may be mixed across
+// translation units. Names in isocpp_p1950::detail are not exported.
+
+module;
+
+#include "indirect_value.h"
+
+export module isocpp_p1950.indirect_value;
+
+export namespace isocpp_p1950 {
+using isocpp_p1950::allocate_indirect_value;
+using isocpp_p1950::allocate_unique;
+using isocpp_p1950::bad_indirect_value_access;
+using isocpp_p1950::copier_traits;
+using isocpp_p1950::default_array_delete;
+using isocpp_p1950::default_copy;
+using isocpp_p1950::indirect_value;
+using isocpp_p1950::indirect_value_error_handler;
+using isocpp_p1950::make_indirect_value;
+using isocpp_p1950::set_bad_indirect_value_access_handler;
+using isocpp_p1950::set_indirect_value_allocation_failure_handler;
+using isocpp_p1950::try_make_indirect_value;
+
+using isocpp_p1950::operator==;
+using isocpp_p1950::operator!=;
+using isocpp_p1950::operator<;
+using isocpp_p1950::operator>;
+using isocpp_p1950::operator<=;
+using isocpp_p1950::operator>=;
+#if defined(__cpp_lib_three_way_comparison) && defined(__cpp_lib_concepts)
+using isocpp_p1950::operator<=>;
+#endif
+}  // namespace isocpp_p1950
@@ -21,8 +21,13 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #ifndef ISOCPP_P1950_INDIRECT_VALUE_H
 #define ISOCPP_P1950_INDIRECT_VALUE_H
 
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
 #include <exception>
 #include <memory>
+#include <new>
 #include <type_traits>
 #include <utility>
 
@@ -30,6 +35,18 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <compare>
 #endif
 
+// With C++20 comparison support, the comparisons between indirect_values and
+// with other types are a constrained operator== and operator<=>, and the
+// compiler synthesizes the rest. Overload resolution then considers a handful
+// of candidates instead of the SFINAE-constrained C++17 set. Types that are
+// not three-way comparable, such as those that only provide operator<, are
+// still ordered through relational operators constrained on that case. Define
+// ISOCPP_P1950_SFINAE_COMPARISONS to keep the C++17 overloads throughout.
+#if defined(__cpp_lib_three_way_comparison) && defined(__cpp_lib_concepts) && \
+    !defined(ISOCPP_P1950_SFINAE_COMPARISONS)
+#define ISOCPP_P1950_CONCEPT_COMPARISONS
+#endif
+
 // MSVC does not apply EBCO for more than one base class, by default. To enable
 // it, you have to write `__declspec(empty_bases)` to the declaration of the
 // derived class. As indirect_value inherits from two EBCO - classes, one for
@@ -47,12 +64,130 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
     #define ISOCPP_P1950_CONSTEXPR_CXX20
 #endif
 
+// Exceptions are used unless the compiler has them disabled (for example with
+// -fno-exceptions) or ISOCPP_P1950_NO_EXCEPTIONS is defined. Without
+// exceptions, errors are reported to handlers that must not return; see
+// set_bad_indirect_value_access_handler and
+// set_indirect_value_allocation_failure_handler.
+#if !defined(ISOCPP_P1950_NO_EXCEPTIONS) && !defined(__cpp_exceptions) && \
+    !defined(__EXCEPTIONS) && !defined(_CPPUNWIND)
+#define ISOCPP_P1950_NO_EXCEPTIONS
+#endif
+
+// Without exceptions, handler blocks are discarded statements: they are never
+// run and, inside templates, never instantiated.
+#ifdef ISOCPP_P1950_NO_EXCEPTIONS
+#define ISOCPP_P1950_TRY if constexpr (true)
+#define ISOCPP_P1950_CATCH_ALL if constexpr (false)
+#define ISOCPP_P1950_RETHROW std::abort()
+#define ISOCPP_P1950_NEW new (std::nothrow)
+#else
+#define ISOCPP_P1950_TRY try
+#define ISOCPP_P1950_CATCH_ALL catch (...)
+#define ISOCPP_P1950_RETHROW throw
+#define ISOCPP_P1950_NEW new
+#endif
+
 namespace isocpp_p1950 {
 
+// Called instead of throwing when exceptions are disabled. If a handler
+// returns, the program is aborted.
+using indirect_value_error_handler = void (*)();
+
+namespace detail {
+
+inline std::atomic<indirect_value_error_handler> bad_access_handler{nullptr};
+inline std::atomic<indirect_value_error_handler> allocation_failure_handler{
+    nullptr};
+
+[[noreturn]] inline void handle_allocation_failure() {
+#ifdef ISOCPP_P1950_NO_EXCEPTIONS
+  if (auto handler = allocation_failure_handler.load()) handler();
+  std::abort();
+#else
+  throw std::bad_alloc();
+#endif
+}
+
+// Returns p. When exceptions are disabled, allocations use nothrow new and a
+// null result is reported to the allocation failure handler.
+template <class T>
+constexpr T* check_allocation(T* p) {
+#ifdef ISOCPP_P1950_NO_EXCEPTIONS
+  if (!p) handle_allocation_failure();
+#endif
+  return p;
+}
+
+template <class T, class... Ts>
+constexpr T* new_object(Ts&&... ts) {
+  return check_allocation(ISOCPP_P1950_NEW T(std::forward<Ts>(ts)...));
+}
+
+// Allocates `bytes` of storage aligned to `align` with operator new, using the
+// nothrow form when exceptions are disabled.
+inline void* allocate_bytes(std::size_t bytes, std::size_t align) {
+#ifdef ISOCPP_P1950_NO_EXCEPTIONS
+  if (align > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+    return check_allocation(
+        ::operator new(bytes, std::align_val_t(align), std::nothrow));
+  }
+  return check_allocation(::operator new(bytes, std::nothrow));
+#else
+  if (align > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+    return ::operator new(bytes, std::align_val_t(align));
+  }
+  return ::operator new(bytes);
+#endif
+}
+
+// Allocates storage for n objects from the allocator a. When exceptions are
+// disabled, std::allocator is bypassed for nothrow operator new, which it
+// would otherwise call in its throwing form, and a null result from any
+// allocator is reported to the allocation failure handler.
+template <class A>
+ISOCPP_P1950_CONSTEXPR_CXX20 typename std::allocator_traits<A>::pointer
+allocate_storage(A& a, std::size_t n) {
+#ifdef ISOCPP_P1950_NO_EXCEPTIONS
+  using T = typename std::allocator_traits<A>::value_type;
+  if constexpr (std::is_same_v<A, std::allocator<T>>) {
+#ifdef __cpp_lib_is_constant_evaluated
+    if (!std::is_constant_evaluated())
+#endif
+    {
+      if (n > std::size_t(-1) / sizeof(T)) handle_allocation_failure();
+      return static_cast<T*>(allocate_bytes(n * sizeof(T), alignof(T)));
+    }
+  }
+  return check_allocation(std::allocator_traits<A>::allocate(a, n));
+#else
+  return std::allocator_traits<A>::allocate(a, n);
+#endif
+}
+
+}  // namespace detail
+
+// Installs the handler called by value() on an empty indirect_value when
+// exceptions are disabled, and returns the previous handler.
+inline indirect_value_error_handler set_bad_indirect_value_access_handler(
+    indirect_value_error_handler handler) noexcept {
+  return detail::bad_access_handler.exchange(handler);
+}
+
+// Installs the handler called when allocating a value fails and exceptions
+// are disabled, and returns the previous handler.
+inline indirect_value_error_handler
+set_indirect_value_allocation_failure_handler(
+    indirect_value_error_handler handler) noexcept {
+  return detail::allocation_failure_handler.exchange(handler);
+}
+
 template <class T>
 struct default_copy {
   using deleter_type = std::default_delete<T>;
-  constexpr T* operator()(const T& t) const { return new T(t); }
+  constexpr T* operator()(const T& t) const {
+    return detail::new_object<T>(t);
+  }
 };
 
 template <class T, class = void>
@@ -81,6 +216,19 @@ class bad_indirect_value_access : public std::exception {
   }
 };
 
+namespace detail {
+
+[[noreturn]] inline void handle_bad_access() {
+#ifdef ISOCPP_P1950_NO_EXCEPTIONS
+  if (auto handler = bad_access_handler.load()) handler();
+  std::abort();
+#else
+  throw bad_indirect_value_access();
+#endif
+}
+
+}  // namespace detail
+
 template <typename T, typename = void>
 constexpr bool is_complete_v = false;
 template <typename T>
@@ -91,24 +239,38 @@ namespace detail
 
 template <typename T, typename A, typename... Args>
 ISOCPP_P1950_CONSTEXPR_CXX20 T* allocate_object(A& a, Args&&... args) {
-  using t_allocator =
-      typename std::allocator_traits<A>::template rebind_alloc<T>;
+  using t_allocator = typename std::allocator_traits<
+      std::remove_const_t<A>>::template rebind_alloc<T>;
   using t_traits = std::allocator_traits<t_allocator>;
   t_allocator t_alloc(a);
-  T* mem = t_traits::allocate(t_alloc, 1);
-  try {
+  T* mem = allocate_storage(t_alloc, 1);
+  ISOCPP_P1950_TRY {
     t_traits::construct(t_alloc, mem, std::forward<Args>(args)...);
     return mem;
-  } catch (...) {
+  } ISOCPP_P1950_CATCH_ALL {
     t_traits::deallocate(t_alloc, mem, 1);
-    throw;
+    ISOCPP_P1950_RETHROW;
   }
 }
 
+// A copier with a construct(args...) member, such as numa_local_copy, makes
+// pointees that only its own deleter can release, so the std::in_place
+// constructor creates the pointee through it too.
+template <class... Ts>
+struct type_list {};
+
+template <class C, class Args, class = void>
+constexpr bool has_construct_v = false;
+template <class C, class... Ts>
+constexpr bool has_construct_v<
+    C, type_list<Ts...>,
+    std::void_t<decltype(std::declval<const C&>().construct(
+        std::declval<Ts>()...))>> = true;
+
 template <typename T, typename A>
 constexpr void deallocate_object(A& a, T* p) {
-  using t_allocator =
-      typename std::allocator_traits<A>::template rebind_alloc<T>;
+  using t_allocator = typename std::allocator_traits<
+      std::remove_const_t<A>>::template rebind_alloc<T>;
   using t_traits = std::allocator_traits<t_allocator>;
   t_allocator t_alloc(a);
   t_traits::destroy(t_alloc, p);
@@ -117,24 +279,195 @@ constexpr void deallocate_object(A& a, T* p) {
 
 template <class T, class A>
 struct allocator_delete : A  {
-    constexpr allocator_delete(A& a) : A(a) {} 
+    constexpr allocator_delete(const A& a) : A(a) {}
     constexpr void operator()(T* ptr) const noexcept { 
         static_assert(0 < sizeof(T), "can't delete an incomplete type");
-        detail::deallocate_object(*this, ptr);
+        detail::deallocate_object(static_cast<const A&>(*this), ptr);
     }
 };
 
 template <class T, class A>
 struct allocator_copy : A {
-  constexpr allocator_copy(A& a) : A(a) {} 
+  constexpr allocator_copy(const A& a) : A(a) {}
   using deleter_type = allocator_delete<T, A>;
+  using allocator_type = A;
   constexpr T* operator()(const T& t) const { 
-    return detail::allocate_object<T>(*this, t);
+    return detail::allocate_object<T>(static_cast<const A&>(*this), t);
+  }
+  constexpr allocator_type get_allocator() const noexcept { return *this; }
+};
+
+// A copier that exposes allocator_type and get_allocator(), and can be
+// constructed from its allocator, makes indirect_value allocator-aware: it
+// gains allocator-extended constructors and get_allocator(), and its
+// assignments and swap follow the allocator's propagation traits. Naming an
+// allocator_type alone is not enough.
+template <class C, class = void>
+constexpr bool is_allocator_aware_copier_v = false;
+template <class C>
+constexpr bool is_allocator_aware_copier_v<
+    C, std::void_t<typename C::allocator_type,
+                   decltype(std::declval<const C&>().get_allocator())>> =
+    std::is_constructible_v<C, const typename C::allocator_type&> &&
+    std::is_convertible_v<decltype(std::declval<const C&>().get_allocator()),
+                          typename C::allocator_type>;
+
+template <class C>
+using copier_allocator_t = typename C::allocator_type;
+
+// Whether an indirect_value with copier C can be constructed from an
+// allocator of type Alloc, as std::uses_allocator requires.
+template <class C, class Alloc, bool = is_allocator_aware_copier_v<C>>
+constexpr bool copier_uses_allocator_v = false;
+template <class C, class Alloc>
+constexpr bool copier_uses_allocator_v<C, Alloc, true> =
+    std::is_convertible_v<Alloc, copier_allocator_t<C>>;
+
+// Copiers that are not allocators always travel with their pointee.
+template <class C, bool = is_allocator_aware_copier_v<C>>
+struct copier_propagation {
+  static constexpr bool on_copy_assignment = true;
+  static constexpr bool on_move_assignment = true;
+  static constexpr bool on_swap = true;
+  static constexpr bool always_equal = true;
+};
+
+template <class C>
+struct copier_propagation<C, true> {
+  using traits = std::allocator_traits<copier_allocator_t<C>>;
+  static constexpr bool on_copy_assignment =
+      traits::propagate_on_container_copy_assignment::value;
+  static constexpr bool on_move_assignment =
+      traits::propagate_on_container_move_assignment::value;
+  static constexpr bool on_swap = traits::propagate_on_container_swap::value;
+  static constexpr bool always_equal = traits::is_always_equal::value;
+};
+
+template <class A>
+constexpr bool is_std_allocator_v = false;
+template <class U>
+constexpr bool is_std_allocator_v<std::allocator<U>> = true;
+
+// Whether copying through A's construct could differ from copying the bytes.
+// std::allocator's construct, deprecated in C++17 and removed in C++20, only
+// placement-news, so it does not count.
+template <class A, class T, class = void>
+constexpr bool has_custom_construct_v = false;
+template <class A, class T>
+constexpr bool has_custom_construct_v<
+    A, T,
+    std::void_t<decltype(std::declval<A&>().construct(
+        std::declval<T*>(), std::declval<const T&>()))>> =
+    !is_std_allocator_v<A>;
+
+// Allocates storage for n objects of type T and initialises it with
+// init(mem). When init throws, the storage is released and the exception is
+// propagated.
+template <typename T, typename A, typename Init>
+T* allocate_array(A& a, std::size_t n, Init&& init) {
+  using t_allocator = typename std::allocator_traits<
+      std::remove_const_t<A>>::template rebind_alloc<T>;
+  using t_traits = std::allocator_traits<t_allocator>;
+  t_allocator t_alloc(a);
+  T* mem = allocate_storage(t_alloc, n);
+  ISOCPP_P1950_TRY {
+    init(t_alloc, mem);
+    return mem;
+  } ISOCPP_P1950_CATCH_ALL {
+    t_traits::deallocate(t_alloc, mem, n);
+    ISOCPP_P1950_RETHROW;
+  }
+}
+
+template <typename T, typename A>
+void destroy_elements(A& t_alloc, T* first, std::size_t n) noexcept {
+  for (std::size_t i = 0; i != n; ++i) {
+    std::allocator_traits<A>::destroy(t_alloc, first + i);
+  }
+}
+
+// Constructs n objects at mem by calling construct(t_alloc, mem + i, i),
+// undoing the constructed prefix when a constructor throws.
+template <typename T, typename A, typename Construct>
+void construct_elements(A& t_alloc, T* mem, std::size_t n,
+                        Construct&& construct) {
+  std::size_t i = 0;
+  ISOCPP_P1950_TRY {
+    for (; i != n; ++i) {
+      construct(t_alloc, mem + i, i);
+    }
+  } ISOCPP_P1950_CATCH_ALL {
+    destroy_elements(t_alloc, mem, i);
+    ISOCPP_P1950_RETHROW;
+  }
+}
+
+template <typename T, typename A>
+T* allocate_array_copy(A& a, const T* src, std::size_t n) {
+  return allocate_array<T>(a, n, [src, n](auto& t_alloc, T* mem) {
+    using t_allocator = std::remove_reference_t<decltype(t_alloc)>;
+    if constexpr (std::is_trivially_copyable_v<T> &&
+                  !has_custom_construct_v<t_allocator, T>) {
+      if (n != 0) std::memcpy(mem, src, n * sizeof(T));
+    } else {
+      construct_elements(t_alloc, mem, n,
+                         [src](auto& ta, T* p, std::size_t i) {
+                           std::allocator_traits<t_allocator>::construct(
+                               ta, p, src[i]);
+                         });
+    }
+  });
+}
+
+template <typename T, typename A>
+void deallocate_array(A& a, T* p, std::size_t n) noexcept {
+  using t_allocator = typename std::allocator_traits<
+      std::remove_const_t<A>>::template rebind_alloc<T>;
+  t_allocator t_alloc(a);
+  destroy_elements(t_alloc, p, n);
+  std::allocator_traits<t_allocator>::deallocate(t_alloc, p, n);
+}
+
+template <class T, class A>
+struct allocator_delete<T[], A> : A {
+  constexpr allocator_delete(const A& a) : A(a) {}
+  void operator()(T* ptr, std::size_t n) const noexcept {
+    detail::deallocate_array(static_cast<const A&>(*this), ptr, n);
+  }
+};
+
+template <class T, class A>
+struct allocator_copy<T[], A> : A {
+  constexpr allocator_copy(const A& a) : A(a) {}
+  using deleter_type = allocator_delete<T[], A>;
+  T* operator()(const T* src, std::size_t n) const {
+    return detail::allocate_array_copy(static_cast<const A&>(*this), src,
+                                       n);
   }
 };
 
 }
 
+// Copiers and deleters of indirect_value<T[]> are passed the element count
+// along with the pointer.
+template <class T>
+struct default_array_delete {
+  void operator()(T* p, std::size_t n) const noexcept {
+    static_assert(0 < sizeof(T), "can't delete an incomplete type");
+    std::allocator<T> a;
+    detail::deallocate_array(a, p, n);
+  }
+};
+
+template <class T>
+struct default_copy<T[]> {
+  using deleter_type = default_array_delete<T>;
+  T* operator()(const T* src, std::size_t n) const {
+    std::allocator<T> a;
+    return detail::allocate_array_copy(a, src, n);
+  }
+};
+
 template <class C,
           bool CanBeEmptyBaseClass = std::is_empty_v<C> && !std::is_final_v<C>>
 class indirect_value_copy_base {
@@ -185,6 +518,7 @@ class ISOCPP_P1950_EMPTY_BASES indirect_value
       private indirect_value_delete_base<D> {
   using copy_base = indirect_value_copy_base<C>;
   using delete_base = indirect_value_delete_base<D>;
+  using propagation = detail::copier_propagation<C>;
 
   T* ptr_ = nullptr;
 
@@ -197,7 +531,7 @@ class ISOCPP_P1950_EMPTY_BASES indirect_value
 
   template <class... Ts>
   constexpr explicit indirect_value(std::in_place_t, Ts&&... ts)
-      : ptr_(new T(std::forward<Ts>(ts)...)) {}
+      : ptr_(construct_pointee(std::forward<Ts>(ts)...)) {}
 
   template <class U, class = std::enable_if_t<std::is_same_v<T, U> &&
       std::is_default_constructible_v<C> &&
@@ -217,8 +551,68 @@ class ISOCPP_P1950_EMPTY_BASES indirect_value
   constexpr explicit indirect_value(U* u, C c, D d) noexcept
       : copy_base(std::move(c)), delete_base(std::move(d)), ptr_(u) {}
 
+  // Adopts the object owned by p, and its deleter, without allocating. The
+  // copier is default constructed, or constructed from the deleter when it
+  // can be, as for the allocator-aware copier and deleter.
+  template <class CC = C, class = std::enable_if_t<
+      std::is_constructible_v<CC, D&> ||
+      (std::is_default_constructible_v<CC> && not std::is_pointer_v<CC>)>>
+  constexpr explicit indirect_value(std::unique_ptr<T, D>&& p) noexcept
+      : copy_base(copier_from(p.get_deleter())),
+        delete_base(std::move(p.get_deleter())),
+        ptr_(p.release()) {}
+
+  constexpr explicit indirect_value(std::unique_ptr<T, D>&& p, C c) noexcept
+      : copy_base(std::move(c)),
+        delete_base(std::move(p.get_deleter())),
+        ptr_(p.release()) {}
+
+  // Allocator-extended constructors, available when the copier is an
+  // allocator. The pointee is allocated from, and owned through, a.
+  template <class CC = C, class = std::enable_if_t<
+      detail::is_allocator_aware_copier_v<CC>>>
+  constexpr indirect_value(std::allocator_arg_t,
+                           const detail::copier_allocator_t<CC>& a) noexcept
+      : copy_base(C(a)), delete_base(D(a)) {}
+
+  template <class... Ts, class CC = C, class = std::enable_if_t<
+      detail::is_allocator_aware_copier_v<CC>>>
+  constexpr indirect_value(std::allocator_arg_t,
+                           const detail::copier_allocator_t<CC>& a,
+                           std::in_place_t, Ts&&... ts)
+      : copy_base(C(a)),
+        delete_base(D(a)),
+        ptr_(detail::allocate_object<T>(a, std::forward<Ts>(ts)...)) {}
+
+  // Adopts u, which must have been allocated from a.
+  template <class U, class CC = C, class = std::enable_if_t<
+      std::is_same_v<T, U> && detail::is_allocator_aware_copier_v<CC>>>
+  constexpr indirect_value(std::allocator_arg_t,
+                           const detail::copier_allocator_t<CC>& a,
+                           U* u) noexcept
+      : copy_base(C(a)), delete_base(D(a)), ptr_(u) {}
+
+  template <class CC = C, class = std::enable_if_t<
+      detail::is_allocator_aware_copier_v<CC>>>
+  constexpr indirect_value(std::allocator_arg_t,
+                           const detail::copier_allocator_t<CC>& a,
+                           const indirect_value& i)
+      : copy_base(C(a)), delete_base(D(a)), ptr_(copy_pointee(i)) {}
+
+  // Takes i's pointee when the allocators are equal, and otherwise moves the
+  // value into storage from a.
+  template <class CC = C, class = std::enable_if_t<
+      detail::is_allocator_aware_copier_v<CC>>>
+  constexpr indirect_value(std::allocator_arg_t,
+                           const detail::copier_allocator_t<CC>& a,
+                           indirect_value&& i)
+      : copy_base(C(a)), delete_base(D(a)), ptr_(take_pointee(i)) {}
+
   constexpr indirect_value(const indirect_value& i)
-      : copy_base(i.get_c()), delete_base(i.get_d()), ptr_(i.make_raw_copy()) {}
+      : copy_base(i.copier_for_copy()),
+        delete_base(i.deleter_for_copy()),
+        ptr_(detail::is_allocator_aware_copier_v<C> ? copy_pointee(i)
+                                                    : i.make_raw_copy()) {}
 
   constexpr indirect_value(indirect_value&& i) noexcept
       : copy_base(std::move(i)),
@@ -226,23 +620,38 @@ class ISOCPP_P1950_EMPTY_BASES indirect_value
         ptr_(std::exchange(i.ptr_, nullptr)) {}
 
   constexpr indirect_value& operator=(const indirect_value& i) {
-    // When copying T throws, *this will remain unchanged.
-    // When assigning copy_base or delete_base throws,
-    // ptr_ will be null.
-    auto temp_guard = i.make_guarded_copy();
-    reset();
-    copy_base::operator=(i);
-    delete_base::operator=(i);
-    ptr_ = temp_guard.release();
+    if constexpr (propagation::on_copy_assignment) {
+      // When copying T throws, *this will remain unchanged.
+      // When assigning copy_base or delete_base throws,
+      // ptr_ will be null.
+      auto temp_guard = i.make_guarded_copy();
+      reset();
+      copy_base::operator=(i);
+      delete_base::operator=(i);
+      ptr_ = temp_guard.release();
+    } else {
+      // The allocator stays put, so the copy is made with our own.
+      T* copy = copy_pointee(i);
+      reset();
+      ptr_ = copy;
+    }
     return *this;
   }
 
-  constexpr indirect_value& operator=(indirect_value&& i) noexcept {
+  constexpr indirect_value& operator=(indirect_value&& i) noexcept(
+      propagation::on_move_assignment || propagation::always_equal) {
     if (this != &i) {
-      reset();
-      copy_base::operator=(std::move(i));
-      delete_base::operator=(std::move(i));
-      ptr_ = std::exchange(i.ptr_, nullptr);
+      if constexpr (propagation::on_move_assignment ||
+                    propagation::always_equal) {
+        reset();
+        copy_base::operator=(std::move(i));
+        delete_base::operator=(std::move(i));
+        ptr_ = std::exchange(i.ptr_, nullptr);
+      } else {
+        T* p = take_pointee(i);
+        reset();
+        ptr_ = p;
+      }
     }
     return *this;
   }
@@ -262,22 +671,22 @@ class ISOCPP_P1950_EMPTY_BASES indirect_value
   constexpr const T&& operator*() const&& noexcept { return std::move(*ptr_); }
 
   constexpr T& value() & {
-    if (!ptr_) throw bad_indirect_value_access();
+    if (!ptr_) detail::handle_bad_access();
     return *ptr_;
   }
 
   constexpr const T& value() const& {
-    if (!ptr_) throw bad_indirect_value_access();
+    if (!ptr_) detail::handle_bad_access();
     return *ptr_;
   }
 
   constexpr T&& value() && {
-    if (!ptr_) throw bad_indirect_value_access();
+    if (!ptr_) detail::handle_bad_access();
     return std::move(*ptr_);
   }
 
   constexpr const T&& value() const&& {
-    if (!ptr_) throw bad_indirect_value_access();
+    if (!ptr_) detail::handle_bad_access();
     return std::move(*ptr_);
   }
 
@@ -293,11 +702,27 @@ class ISOCPP_P1950_EMPTY_BASES indirect_value
 
   constexpr const deleter_type& get_deleter() const noexcept { return get_d(); }
 
+  template <class CC = C, class = std::enable_if_t<
+      detail::is_allocator_aware_copier_v<CC>>>
+  constexpr detail::copier_allocator_t<CC> get_allocator() const noexcept {
+    return get_c().get_allocator();
+  }
+
+  // Transfers ownership of the pointee to a unique_ptr holding a copy of the
+  // deleter, leaving *this empty.
+  std::unique_ptr<T, D> release() noexcept {
+    return std::unique_ptr<T, D>(std::exchange(ptr_, nullptr), get_d());
+  }
+
+  // When the allocator does not propagate on swap, the allocators of *this
+  // and rhs must compare equal.
   constexpr void swap(indirect_value& rhs) noexcept(
       std::is_nothrow_swappable_v<C>&& std::is_nothrow_swappable_v<D>) {
     using std::swap;
-    swap(get_c(), rhs.get_c());
-    swap(get_d(), rhs.get_d());
+    if constexpr (propagation::on_swap) {
+      swap(get_c(), rhs.get_c());
+      swap(get_d(), rhs.get_d());
+    }
     swap(ptr_, rhs.ptr_);
   }
 
@@ -324,6 +749,65 @@ class ISOCPP_P1950_EMPTY_BASES indirect_value
     }
   }
 
+  template <class... Ts>
+  constexpr T* construct_pointee(Ts&&... ts) const {
+    if constexpr (detail::has_construct_v<C, detail::type_list<Ts&&...>>) {
+      return get_c().construct(std::forward<Ts>(ts)...);
+    } else {
+      return detail::new_object<T>(std::forward<Ts>(ts)...);
+    }
+  }
+
+  // The copier and deleter for a copy of *this. Allocators are chosen by
+  // select_on_container_copy_construction; anything else is copied as is.
+  constexpr decltype(auto) copier_for_copy() const {
+    if constexpr (detail::is_allocator_aware_copier_v<C>) {
+      using traits = std::allocator_traits<detail::copier_allocator_t<C>>;
+      return C(traits::select_on_container_copy_construction(
+          get_c().get_allocator()));
+    } else {
+      return (get_c());
+    }
+  }
+
+  constexpr decltype(auto) deleter_for_copy() const {
+    if constexpr (detail::is_allocator_aware_copier_v<C>) {
+      using traits = std::allocator_traits<detail::copier_allocator_t<C>>;
+      return D(traits::select_on_container_copy_construction(
+          get_c().get_allocator()));
+    } else {
+      return (get_d());
+    }
+  }
+
+  // Copies i's pointee with this object's copier, which must already be
+  // initialised.
+  constexpr T* copy_pointee(const indirect_value& i) const {
+    return i.ptr_ ? get_c()(*i.ptr_) : nullptr;
+  }
+
+  // Takes i's pointee, or moves its value into storage from this object's
+  // allocator when the allocators differ. Leaves i empty.
+  constexpr T* take_pointee(indirect_value& i) {
+    if constexpr (!propagation::always_equal) {
+      if (i.ptr_ && !(get_allocator() == i.get_allocator())) {
+        const auto a = get_allocator();
+        T* p = detail::allocate_object<T>(a, std::move_if_noexcept(*i.ptr_));
+        i.reset();
+        return p;
+      }
+    }
+    return std::exchange(i.ptr_, nullptr);
+  }
+
+  static constexpr C copier_from([[maybe_unused]] D& d) {
+    if constexpr (std::is_constructible_v<C, D&>) {
+      return C(d);
+    } else {
+      return C{};
+    }
+  }
+
   constexpr T* make_raw_copy() const { return ptr_ ? get_c()(*ptr_) : nullptr; }
 
   constexpr std::unique_ptr<T, std::reference_wrapper<const D>>
@@ -339,24 +823,269 @@ class ISOCPP_P1950_EMPTY_BASES indirect_value
 template <class T>
 indirect_value(T*) -> indirect_value<T>;
 
+template <class T>
+indirect_value(std::unique_ptr<T>&&) -> indirect_value<T>;
+
+template <class T, class A>
+indirect_value(std::unique_ptr<T, detail::allocator_delete<T, A>>&&)
+    -> indirect_value<T, detail::allocator_copy<T, A>,
+                      detail::allocator_delete<T, A>>;
+
+// An owned array of runtime size held in a single allocation.
+//
+// indirect_value<T[]> stores the element pointer and the element count, so a
+// variable-length buffer costs one allocation and one indirection rather than
+// the two of indirect_value<std::vector<T>>. It deep copies and propagates
+// const like indirect_value<T>. Its copier is invoked as c(ptr, size) and
+// returns a new array of the same size; its deleter is invoked as
+// d(ptr, size).
+template <class T, class C, class D>
+class ISOCPP_P1950_EMPTY_BASES indirect_value<T[], C, D>
+    : private indirect_value_copy_base<C>,
+      private indirect_value_delete_base<D> {
+  using copy_base = indirect_value_copy_base<C>;
+  using delete_base = indirect_value_delete_base<D>;
+
+  T* ptr_ = nullptr;
+  std::size_t size_ = 0;
+
+ public:
+  using value_type = T[];
+  using element_type = T;
+  using size_type = std::size_t;
+  using iterator = T*;
+  using const_iterator = const T*;
+  using copier_type = C;
+  using deleter_type = D;
+
+  constexpr indirect_value() = default;
+
+  template <class U, class = std::enable_if_t<std::is_same_v<T, U> &&
+      std::is_default_constructible_v<C> &&
+      not std::is_pointer_v<C> &&
+      std::is_default_constructible_v<D> &&
+      not std::is_pointer_v<D>>>
+  constexpr explicit indirect_value(U* u, std::size_t n) noexcept
+      : copy_base(C{}), delete_base(D{}), ptr_(u), size_(u ? n : 0) {}
+
+  template <class U, class = std::enable_if_t<std::is_same_v<T, U> &&
+      std::is_default_constructible_v<D> &&
+      not std::is_pointer_v<D>>>
+  constexpr explicit indirect_value(U* u, std::size_t n, C c) noexcept
+      : copy_base(std::move(c)), delete_base(D{}), ptr_(u), size_(u ? n : 0) {}
+
+  template <class U, class = std::enable_if_t<std::is_same_v<T, U>>>
+  constexpr explicit indirect_value(U* u, std::size_t n, C c, D d) noexcept
+      : copy_base(std::move(c)),
+        delete_base(std::move(d)),
+        ptr_(u),
+        size_(u ? n : 0) {}
+
+  constexpr indirect_value(const indirect_value& i)
+      : copy_base(i.get_c()),
+        delete_base(i.get_d()),
+        ptr_(i.make_raw_copy()),
+        size_(i.size_) {}
+
+  constexpr indirect_value(indirect_value&& i) noexcept
+      : copy_base(std::move(i)),
+        delete_base(std::move(i)),
+        ptr_(std::exchange(i.ptr_, nullptr)),
+        size_(std::exchange(i.size_, 0)) {}
+
+  constexpr indirect_value& operator=(const indirect_value& i) {
+    // When copying T throws, *this will remain unchanged.
+    // When assigning copy_base or delete_base throws,
+    // ptr_ will be null.
+    auto temp_guard = i.make_guarded_copy();
+    reset();
+    copy_base::operator=(i);
+    delete_base::operator=(i);
+    size_ = temp_guard.size;
+    ptr_ = temp_guard.release();
+    return *this;
+  }
+
+  constexpr indirect_value& operator=(indirect_value&& i) noexcept {
+    if (this != &i) {
+      reset();
+      copy_base::operator=(std::move(i));
+      delete_base::operator=(std::move(i));
+      ptr_ = std::exchange(i.ptr_, nullptr);
+      size_ = std::exchange(i.size_, 0);
+    }
+    return *this;
+  }
+
+  ISOCPP_P1950_CONSTEXPR_CXX20 ~indirect_value() { reset(); }
+
+  constexpr T& operator[](std::size_t i) noexcept { return ptr_[i]; }
+
+  constexpr const T& operator[](std::size_t i) const noexcept {
+    return ptr_[i];
+  }
+
+  constexpr T* data() noexcept { return ptr_; }
+
+  constexpr const T* data() const noexcept { return ptr_; }
+
+  constexpr std::size_t size() const noexcept { return size_; }
+
+  constexpr iterator begin() noexcept { return ptr_; }
+
+  constexpr const_iterator begin() const noexcept { return ptr_; }
+
+  constexpr iterator end() noexcept { return ptr_ + size_; }
+
+  constexpr const_iterator end() const noexcept { return ptr_ + size_; }
+
+  explicit constexpr operator bool() const noexcept { return ptr_ != nullptr; }
+
+  constexpr bool has_value() const noexcept { return ptr_ != nullptr; }
+
+  constexpr copier_type& get_copier() noexcept { return get_c(); }
+
+  constexpr const copier_type& get_copier() const noexcept { return get_c(); }
+
+  constexpr deleter_type& get_deleter() noexcept { return get_d(); }
+
+  constexpr const deleter_type& get_deleter() const noexcept { return get_d(); }
+
+  constexpr void swap(indirect_value& rhs) noexcept(
+      std::is_nothrow_swappable_v<C>&& std::is_nothrow_swappable_v<D>) {
+    using std::swap;
+    swap(get_c(), rhs.get_c());
+    swap(get_d(), rhs.get_d());
+    swap(ptr_, rhs.ptr_);
+    swap(size_, rhs.size_);
+  }
+
+  template <class TC = C>
+  friend constexpr std::enable_if_t<std::is_swappable_v<TC> &&
+                                    std::is_swappable_v<D>>
+  swap(indirect_value& lhs,
+       indirect_value& rhs) noexcept(noexcept(lhs.swap(rhs))) {
+    lhs.swap(rhs);
+  }
+
+ private:
+  constexpr C& get_c() noexcept { return copy_base::get(); }
+  constexpr const C& get_c() const noexcept { return copy_base::get(); }
+  constexpr D& get_d() noexcept { return delete_base::get(); }
+  constexpr const D& get_d() const noexcept { return delete_base::get(); }
+
+  constexpr void reset() noexcept {
+    if (ptr_) {
+      // As for indirect_value<T>, null ptr_ before calling the deleter.
+      get_d()(std::exchange(ptr_, nullptr), std::exchange(size_, 0));
+    }
+  }
+
+  constexpr T* make_raw_copy() const {
+    return ptr_ ? get_c()(ptr_, size_) : nullptr;
+  }
+
+  // Owns a copy until it is released, like the unique_ptr that
+  // indirect_value<T>::make_guarded_copy returns.
+  struct guarded_copy {
+    const D& d;
+    T* ptr;
+    std::size_t size;
+
+    ~guarded_copy() {
+      if (ptr) d(ptr, size);
+    }
+    T* release() noexcept { return std::exchange(ptr, nullptr); }
+  };
+
+  constexpr guarded_copy make_guarded_copy() const {
+    return {get_d(), make_raw_copy(), size_};
+  }
+};
+
 template <class T, class... Ts>
-constexpr indirect_value<T> make_indirect_value(Ts&&... ts) {
+constexpr auto make_indirect_value(Ts&&... ts)
+    -> std::enable_if_t<!std::is_array_v<T>, indirect_value<T>> {
   return indirect_value<T>(std::in_place_t{}, std::forward<Ts>(ts)...);
 }
 
-template <class T, class A = std::allocator<T>, class... Ts>
+// Creates an indirect_value holding T(ts...), or an empty indirect_value if
+// memory cannot be allocated. Allocation failure is not reported to the
+// allocation failure handler.
+template <class T, class... Ts>
+auto try_make_indirect_value(Ts&&... ts)
+    -> std::enable_if_t<!std::is_array_v<T>, indirect_value<T>> {
+  return indirect_value<T>(new (std::nothrow) T(std::forward<Ts>(ts)...));
+}
+
+// Creates an array of n value-initialised elements.
+template <class T>
+auto make_indirect_value(std::size_t n)
+    -> std::enable_if_t<std::is_array_v<T> && std::extent_v<T> == 0,
+                        indirect_value<T>> {
+  using E = std::remove_extent_t<T>;
+  std::allocator<E> a;
+  E* p = detail::allocate_array<E>(a, n, [n](auto&, E* mem) {
+    std::uninitialized_value_construct_n(mem, n);
+  });
+  return indirect_value<T>(p, n);
+}
+
+template <class T, class A = std::allocator<T>, class... Ts,
+          class = std::enable_if_t<!std::is_array_v<T>>>
 ISOCPP_P1950_CONSTEXPR_CXX20 auto allocate_indirect_value(std::allocator_arg_t, A& a, Ts&&... ts) {
   auto* u = detail::allocate_object<T>(a, std::forward<Ts>(ts)...);
-  try {
+  ISOCPP_P1950_TRY {
     return indirect_value<T, detail::allocator_copy<T, A>, detail::allocator_delete<T, A>>(u, {a}, {a});
-  } catch (...) {
+  } ISOCPP_P1950_CATCH_ALL {
     detail::deallocate_object(a, u);
-    throw;
+    ISOCPP_P1950_RETHROW;
   }
 }
 
+// Creates an object with storage obtained from a, owned by a unique_ptr whose
+// deleter keeps a copy of the allocator. The result can be adopted by the
+// indirect_value returned from allocate_indirect_value without allocating.
+template <class T, class A = std::allocator<T>, class... Ts,
+          class = std::enable_if_t<!std::is_array_v<T>>>
+auto allocate_unique(std::allocator_arg_t, A& a, Ts&&... ts) {
+  auto* u = detail::allocate_object<T>(a, std::forward<Ts>(ts)...);
+  return std::unique_ptr<T, detail::allocator_delete<T, A>>(
+      u, detail::allocator_delete<T, A>(a));
+}
+
+// Creates an array of n elements, each constructed from ts..., with storage
+// obtained from a.
+template <class T, class A, class... Ts,
+          class = std::enable_if_t<std::is_array_v<T> && std::extent_v<T> == 0>>
+auto allocate_indirect_value(std::allocator_arg_t, A& a, std::size_t n,
+                             const Ts&... ts) {
+  using E = std::remove_extent_t<T>;
+  E* p = detail::allocate_array<E>(a, n, [n, &ts...](auto& t_alloc, E* mem) {
+    detail::construct_elements(t_alloc, mem, n,
+                               [&ts...](auto& ta, E* e, std::size_t) {
+                                 using traits = std::allocator_traits<
+                                     std::remove_reference_t<decltype(ta)>>;
+                                 traits::construct(ta, e, ts...);
+                               });
+  });
+  return indirect_value<T, detail::allocator_copy<T, A>,
+                        detail::allocator_delete<T, A>>(p, n, {a}, {a});
+}
+
 
 // Relational operators between two indirect_values.
+#if defined(ISOCPP_P1950_CONCEPT_COMPARISONS)
+template <class T1, class C1, class D1, class T2, class C2, class D2>
+  requires requires(const T1& a, const T2& b) {
+    { a == b } -> std::convertible_to<bool>;
+  }
+constexpr bool operator==(const indirect_value<T1, C1, D1>& lhs,
+                          const indirect_value<T2, C2, D2>& rhs) {
+  const bool leftHasValue = bool(lhs);
+  return leftHasValue == bool(rhs) && (!leftHasValue || *lhs == *rhs);
+}
+#else
 template <class T1, class C1, class D1, class T2, class C2, class D2>
 constexpr bool operator==(const indirect_value<T1, C1, D1>& lhs,
                 const indirect_value<T2, C2, D2>& rhs) {
@@ -394,6 +1123,24 @@ constexpr bool operator>=(const indirect_value<T1, C1, D1>& lhs,
                 const indirect_value<T2, C2, D2>& rhs) {
   return !bool(rhs) || (bool(lhs) && *lhs >= *rhs);
 }
+#endif
+
+// Equality between two arrays compares sizes and then elements.
+template <class T1, class C1, class D1, class T2, class C2, class D2>
+constexpr bool operator==(const indirect_value<T1[], C1, D1>& lhs,
+                          const indirect_value<T2[], C2, D2>& rhs) {
+  if (bool(lhs) != bool(rhs) || lhs.size() != rhs.size()) return false;
+  for (std::size_t i = 0; i != lhs.size(); ++i) {
+    if (!(lhs[i] == rhs[i])) return false;
+  }
+  return true;
+}
+
+template <class T1, class C1, class D1, class T2, class C2, class D2>
+constexpr bool operator!=(const indirect_value<T1[], C1, D1>& lhs,
+                          const indirect_value<T2[], C2, D2>& rhs) {
+  return !(lhs == rhs);
+}
 
 #if defined(__cpp_lib_three_way_comparison) && defined(__cpp_lib_concepts)
 template <class T1, class C1, class D1, std::three_way_comparable_with<T1> T2,
@@ -524,6 +1271,7 @@ using _enable_if_comparable_with_greater_equal =
     _enable_if_convertible_to_bool<decltype(std::declval<const LHS&>() >=
                                             std::declval<const RHS&>())>;
 
+#if !defined(ISOCPP_P1950_CONCEPT_COMPARISONS)
 template <class T, class C, class D, class U>
 constexpr auto operator==(const indirect_value<T, C, D>& lhs, const U& rhs)
     -> _enable_if_comparable_with_equal<T, U> {
@@ -596,6 +1344,8 @@ constexpr auto operator>=(const T& lhs, const indirect_value<U, C, D>& rhs)
   return !rhs || lhs >= *rhs;
 }
 
+#endif
+
 #if defined(__cpp_lib_three_way_comparison) && defined(__cpp_lib_concepts)
 
 template <class>
@@ -604,12 +1354,141 @@ inline constexpr bool _is_indirect_value_v = false;
 template <class T, class C, class D>
 inline constexpr bool _is_indirect_value_v<indirect_value<T, C, D>> = true;
 
+#if defined(ISOCPP_P1950_CONCEPT_COMPARISONS)
+template <class T, class C, class D, class U>
+  requires(!_is_indirect_value_v<U>) && requires(const T& t, const U& u) {
+    { t == u } -> std::convertible_to<bool>;
+  }
+constexpr bool operator==(const indirect_value<T, C, D>& lhs, const U& rhs) {
+  return lhs && *lhs == rhs;
+}
+#endif
+
 template <class T, class C, class D, class U>
 requires(!_is_indirect_value_v<U>) &&
     std::three_way_comparable_with<T, U> std::compare_three_way_result_t<T, U>
     operator<=>(const indirect_value<T, C, D>& lhs, const U& rhs) {
   return bool(lhs) ? *lhs <=> rhs : std::strong_ordering::less;
 }
+
+#if defined(ISOCPP_P1950_CONCEPT_COMPARISONS)
+// Types that provide the relational operators but no operator<=> are ordered
+// with the C++17 relational operators, as operator<=> is unavailable.
+template <class T, class U>
+concept _ordered_without_three_way = !std::three_way_comparable_with<T, U>;
+
+template <class T1, class C1, class D1, class T2, class C2, class D2>
+  requires _ordered_without_three_way<T1, T2> &&
+           requires(const T1& a, const T2& b) {
+             { a < b } -> std::convertible_to<bool>;
+           }
+constexpr bool operator<(const indirect_value<T1, C1, D1>& lhs,
+                         const indirect_value<T2, C2, D2>& rhs) {
+  return bool(rhs) && (!bool(lhs) || *lhs < *rhs);
+}
+
+template <class T1, class C1, class D1, class T2, class C2, class D2>
+  requires _ordered_without_three_way<T1, T2> &&
+           requires(const T1& a, const T2& b) {
+             { a > b } -> std::convertible_to<bool>;
+           }
+constexpr bool operator>(const indirect_value<T1, C1, D1>& lhs,
+                         const indirect_value<T2, C2, D2>& rhs) {
+  return bool(lhs) && (!bool(rhs) || *lhs > *rhs);
+}
+
+template <class T1, class C1, class D1, class T2, class C2, class D2>
+  requires _ordered_without_three_way<T1, T2> &&
+           requires(const T1& a, const T2& b) {
+             { a <= b } -> std::convertible_to<bool>;
+           }
+constexpr bool operator<=(const indirect_value<T1, C1, D1>& lhs,
+                          const indirect_value<T2, C2, D2>& rhs) {
+  return !bool(lhs) || (bool(rhs) && *lhs <= *rhs);
+}
+
+template <class T1, class C1, class D1, class T2, class C2, class D2>
+  requires _ordered_without_three_way<T1, T2> &&
+           requires(const T1& a, const T2& b) {
+             { a >= b } -> std::convertible_to<bool>;
+           }
+constexpr bool operator>=(const indirect_value<T1, C1, D1>& lhs,
+                          const indirect_value<T2, C2, D2>& rhs) {
+  return !bool(rhs) || (bool(lhs) && *lhs >= *rhs);
+}
+
+template <class T, class C, class D, class U>
+  requires(!_is_indirect_value_v<U>) && _ordered_without_three_way<T, U> &&
+          requires(const T& t, const U& u) {
+            { t < u } -> std::convertible_to<bool>;
+          }
+constexpr bool operator<(const indirect_value<T, C, D>& lhs, const U& rhs) {
+  return !lhs || *lhs < rhs;
+}
+
+template <class T, class C, class D, class U>
+  requires(!_is_indirect_value_v<T>) && _ordered_without_three_way<T, U> &&
+          requires(const T& t, const U& u) {
+            { t < u } -> std::convertible_to<bool>;
+          }
+constexpr bool operator<(const T& lhs, const indirect_value<U, C, D>& rhs) {
+  return rhs && lhs < *rhs;
+}
+
+template <class T, class C, class D, class U>
+  requires(!_is_indirect_value_v<U>) && _ordered_without_three_way<T, U> &&
+          requires(const T& t, const U& u) {
+            { t > u } -> std::convertible_to<bool>;
+          }
+constexpr bool operator>(const indirect_value<T, C, D>& lhs, const U& rhs) {
+  return lhs && *lhs > rhs;
+}
+
+template <class T, class C, class D, class U>
+  requires(!_is_indirect_value_v<T>) && _ordered_without_three_way<T, U> &&
+          requires(const T& t, const U& u) {
+            { t > u } -> std::convertible_to<bool>;
+          }
+constexpr bool operator>(const T& lhs, const indirect_value<U, C, D>& rhs) {
+  return !rhs || lhs > *rhs;
+}
+
+template <class T, class C, class D, class U>
+  requires(!_is_indirect_value_v<U>) && _ordered_without_three_way<T, U> &&
+          requires(const T& t, const U& u) {
+            { t <= u } -> std::convertible_to<bool>;
+          }
+constexpr bool operator<=(const indirect_value<T, C, D>& lhs, const U& rhs) {
+  return !lhs || *lhs <= rhs;
+}
+
+template <class T, class C, class D, class U>
+  requires(!_is_indirect_value_v<T>) && _ordered_without_three_way<T, U> &&
+          requires(const T& t, const U& u) {
+            { t <= u } -> std::convertible_to<bool>;
+          }
+constexpr bool operator<=(const T& lhs, const indirect_value<U, C, D>& rhs) {
+  return rhs && lhs <= *rhs;
+}
+
+template <class T, class C, class D, class U>
+  requires(!_is_indirect_value_v<U>) && _ordered_without_three_way<T, U> &&
+          requires(const T& t, const U& u) {
+            { t >= u } -> std::convertible_to<bool>;
+          }
+constexpr bool operator>=(const indirect_value<T, C, D>& lhs, const U& rhs) {
+  return lhs && *lhs >= rhs;
+}
+
+template <class T, class C, class D, class U>
+  requires(!_is_indirect_value_v<T>) && _ordered_without_three_way<T, U> &&
+          requires(const T& t, const U& u) {
+            { t >= u } -> std::convertible_to<bool>;
+          }
+constexpr bool operator>=(const T& lhs, const indirect_value<U, C, D>& rhs) {
+  return !rhs || lhs >= *rhs;
+}
+#endif
 #endif
 
 template <class IndirectValue, bool Enabled>
@@ -637,6 +1516,12 @@ struct _conditionally_enabled_hash<T,
 }  // namespace isocpp_p1950
 
 namespace std {
+template <class T, class C, class D, class Alloc>
+struct uses_allocator<::isocpp_p1950::indirect_value<T, C, D>, Alloc>
+    : bool_constant<
+          ::isocpp_p1950::detail::copier_uses_allocator_v<C, Alloc> &&
+          !is_array_v<T>> {};
+
 template <class T, class C, class D>
 struct hash<::isocpp_p1950::indirect_value<T, C, D>>
     : ::isocpp_p1950::_conditionally_enabled_hash<
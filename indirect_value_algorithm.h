@@ -0,0 +1,528 @@
+/* Copyright (c) 2019 The Indirect Value Authors. All Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+==============================================================================*/
+
+#ifndef ISOCPP_P1950_INDIRECT_VALUE_ALGORITHM_H
+#define ISOCPP_P1950_INDIRECT_VALUE_ALGORITHM_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+#include "indirect_value.h"
+
+#if (defined(__GNUC__) || defined(__clang__)) && \
+    (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define ISOCPP_P1950_X86_GATHER 1
+#else
+#define ISOCPP_P1950_X86_GATHER 0
+#endif
+
+namespace isocpp_p1950 {
+
+namespace detail {
+
+template <class T>
+struct indirect_value_traits {
+  static constexpr bool is_indirect_value = false;
+};
+
+template <class T, class C, class D>
+struct indirect_value_traits<indirect_value<T, C, D>> {
+  static constexpr bool is_indirect_value = true;
+  using value_type = T;
+};
+
+template <class Range>
+using range_element_t = std::remove_cv_t<
+    std::remove_reference_t<decltype(*std::data(std::declval<Range&>()))>>;
+
+// The value type of a contiguous range of indirect_values over an arithmetic
+// type. Substitution fails for any other range.
+template <class Range, class Traits = indirect_value_traits<
+                           range_element_t<const Range>>>
+using arithmetic_range_value_t = std::enable_if_t<
+    Traits::is_indirect_value &&
+        std::is_arithmetic_v<typename Traits::value_type>,
+    typename Traits::value_type>;
+
+enum class gather_isa { scalar, avx2, avx512 };
+
+inline gather_isa best_gather_isa() noexcept {
+#if ISOCPP_P1950_X86_GATHER
+  static const gather_isa isa = [] {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return gather_isa::avx512;
+    if (__builtin_cpu_supports("avx2")) return gather_isa::avx2;
+    return gather_isa::scalar;
+  }();
+  return isa;
+#else
+  return gather_isa::scalar;
+#endif
+}
+
+template <class IV, class T>
+void gather_scalar(const IV* first, std::size_t n, T* out, T empty) noexcept {
+  for (std::size_t i = 0; i != n; ++i) {
+    const T* p = first[i].operator->();
+    out[i] = p ? *p : empty;
+  }
+}
+
+#if ISOCPP_P1950_X86_GATHER
+// The hardware gathers use a null base address and the pointee addresses as
+// 64-bit indices. Lanes whose pointer is null are masked off and keep the
+// empty value. Pointers are read through operator-> so no assumption is made
+// about the layout of indirect_value.
+
+template <class IV>
+__attribute__((target("avx2"))) void gather_avx2(const IV* first,
+                                                 std::size_t n, double* out,
+                                                 double empty) noexcept {
+  const __m256d fill = _mm256_set1_pd(empty);
+  const __m256i zero = _mm256_setzero_si256();
+  std::size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    const double* ptrs[4] = {first[i].operator->(), first[i + 1].operator->(),
+                             first[i + 2].operator->(),
+                             first[i + 3].operator->()};
+    const __m256i idx =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ptrs));
+    const __m256d engaged = _mm256_castsi256_pd(
+        _mm256_xor_si256(_mm256_cmpeq_epi64(idx, zero),
+                         _mm256_set1_epi64x(-1)));
+    _mm256_storeu_pd(out + i, _mm256_mask_i64gather_pd(
+                                  fill, nullptr, idx, engaged, 1));
+  }
+  gather_scalar(first + i, n - i, out + i, empty);
+}
+
+template <class IV>
+__attribute__((target("avx2"))) void gather_avx2(const IV* first,
+                                                 std::size_t n, float* out,
+                                                 float empty) noexcept {
+  const __m128 fill = _mm_set1_ps(empty);
+  const __m256i zero = _mm256_setzero_si256();
+  std::size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    const float* ptrs[4] = {first[i].operator->(), first[i + 1].operator->(),
+                            first[i + 2].operator->(),
+                            first[i + 3].operator->()};
+    const __m256i idx =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ptrs));
+    const __m256i null_lanes = _mm256_cmpeq_epi64(idx, zero);
+    // Narrow the 64-bit lane mask to the four 32-bit lanes of the result.
+    const __m128i narrowed = _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(
+        null_lanes, _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6)));
+    const __m128 engaged =
+        _mm_castsi128_ps(_mm_xor_si128(narrowed, _mm_set1_epi32(-1)));
+    _mm_storeu_ps(out + i,
+                  _mm256_mask_i64gather_ps(fill, nullptr, idx, engaged, 1));
+  }
+  gather_scalar(first + i, n - i, out + i, empty);
+}
+
+template <class IV>
+__attribute__((target("avx512f"))) void gather_avx512(const IV* first,
+                                                      std::size_t n,
+                                                      double* out,
+                                                      double empty) noexcept {
+  const __m512d fill = _mm512_set1_pd(empty);
+  const __m512i zero = _mm512_setzero_si512();
+  std::size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    const double* ptrs[8];
+    for (int lane = 0; lane < 8; ++lane) {
+      ptrs[lane] = first[i + lane].operator->();
+    }
+    const __m512i idx = _mm512_loadu_si512(ptrs);
+    const __mmask8 engaged = _mm512_cmpneq_epi64_mask(idx, zero);
+    _mm512_storeu_pd(out + i,
+                     _mm512_mask_i64gather_pd(fill, engaged, idx, nullptr, 1));
+  }
+  gather_scalar(first + i, n - i, out + i, empty);
+}
+
+template <class IV>
+__attribute__((target("avx512f"))) void gather_avx512(const IV* first,
+                                                      std::size_t n,
+                                                      float* out,
+                                                      float empty) noexcept {
+  const __m256 fill = _mm256_set1_ps(empty);
+  const __m512i zero = _mm512_setzero_si512();
+  std::size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    const float* ptrs[8];
+    for (int lane = 0; lane < 8; ++lane) {
+      ptrs[lane] = first[i + lane].operator->();
+    }
+    const __m512i idx = _mm512_loadu_si512(ptrs);
+    const __mmask8 engaged = _mm512_cmpneq_epi64_mask(idx, zero);
+    _mm256_storeu_ps(out + i,
+                     _mm512_mask_i64gather_ps(fill, engaged, idx, nullptr, 1));
+  }
+  gather_scalar(first + i, n - i, out + i, empty);
+}
+#endif
+
+// Copies the pointees of [first, first + n) to out, writing `empty` for
+// indirect_values without a value, using the given instruction set.
+template <class IV, class T>
+void gather_block(const IV* first, std::size_t n, T* out, T empty,
+                  gather_isa isa) noexcept {
+#if ISOCPP_P1950_X86_GATHER
+  if constexpr ((std::is_same_v<T, double> || std::is_same_v<T, float>) &&
+                sizeof(void*) == 8) {
+    switch (isa) {
+      case gather_isa::avx512:
+        return gather_avx512(first, n, out, empty);
+      case gather_isa::avx2:
+        return gather_avx2(first, n, out, empty);
+      case gather_isa::scalar:
+        break;
+    }
+  }
+#endif
+  (void)isa;
+  gather_scalar(first, n, out, empty);
+}
+
+inline constexpr std::size_t gather_block_size = 256;
+
+// Gathers the range block by block into a stack buffer and calls
+// f(buffer, count) for each block.
+template <class Range, class T, class F>
+void for_each_gathered_block(const Range& r, T empty, F&& f) {
+  const auto* first = std::data(r);
+  const std::size_t n = std::size(r);
+  const gather_isa isa = best_gather_isa();
+  T buffer[gather_block_size];
+  for (std::size_t i = 0; i < n; i += gather_block_size) {
+    const std::size_t count =
+        n - i < gather_block_size ? n - i : gather_block_size;
+    gather_block(first + i, count, buffer, empty, isa);
+    f(static_cast<const T*>(buffer), count);
+  }
+}
+
+}  // namespace detail
+
+// Algorithms over contiguous ranges (vector, array, span, ...) of
+// indirect_value<T> for arithmetic T. Empty indirect_values contribute
+// `empty_value`. For float and double the pointees are loaded with AVX2 or
+// AVX-512 gather instructions when the CPU supports them, selected at run
+// time; other types and other targets use a scalar loop.
+
+// Writes the value of each element, or empty_value, to out.
+template <class Range, class OutputIt>
+OutputIt gather(const Range& r, OutputIt out,
+                detail::arithmetic_range_value_t<Range> empty_value = {}) {
+  using T = detail::arithmetic_range_value_t<Range>;
+  detail::for_each_gathered_block(r, empty_value,
+                                  [&out](const T* block, std::size_t count) {
+                                    for (std::size_t i = 0; i != count; ++i) {
+                                      *out++ = block[i];
+                                    }
+                                  });
+  return out;
+}
+
+// Reduces the transformed values of the elements, like std::transform_reduce.
+// The order in which elements are combined is unspecified.
+template <class Range, class U, class BinaryOp, class UnaryOp>
+U transform_reduce(const Range& r, U init, BinaryOp reduce, UnaryOp transform,
+                   detail::arithmetic_range_value_t<Range> empty_value = {}) {
+  using T = detail::arithmetic_range_value_t<Range>;
+  detail::for_each_gathered_block(
+      r, empty_value, [&](const T* block, std::size_t count) {
+        for (std::size_t i = 0; i != count; ++i) {
+          init = reduce(std::move(init), transform(block[i]));
+        }
+      });
+  return init;
+}
+
+// The sum of the elements. Floating-point values are accumulated in several
+// independent lanes, so the result may differ from a sequential sum by
+// rounding.
+template <class Range>
+auto sum(const Range& r,
+         detail::arithmetic_range_value_t<Range> empty_value = {}) {
+  using T = detail::arithmetic_range_value_t<Range>;
+  constexpr std::size_t lanes = 8;
+  T acc[lanes] = {};
+  detail::for_each_gathered_block(
+      r, empty_value, [&acc](const T* block, std::size_t count) {
+        std::size_t i = 0;
+        for (; i + lanes <= count; i += lanes) {
+          for (std::size_t l = 0; l != lanes; ++l) acc[l] += block[i + l];
+        }
+        for (; i != count; ++i) acc[0] += block[i];
+      });
+  T total = T();
+  for (T a : acc) total += a;
+  return total;
+}
+
+namespace detail {
+
+// Folds the gathered elements of `r` with `pick` into several independent
+// lanes, so that the loop is not serialised on a single dependency chain.
+template <class Range, class T, class Pick>
+T lane_fold(const Range& r, T empty_value, Pick pick) {
+  constexpr std::size_t lanes = 8;
+  T acc[lanes];
+  bool first = true;
+  for_each_gathered_block(r, empty_value, [&](const T* block,
+                                               std::size_t count) {
+    if (first) std::fill(std::begin(acc), std::end(acc), block[0]);
+    first = false;
+    std::size_t i = 0;
+    for (; i + lanes <= count; i += lanes) {
+      for (std::size_t l = 0; l != lanes; ++l) {
+        acc[l] = pick(acc[l], block[i + l]);
+      }
+    }
+    for (; i != count; ++i) acc[0] = pick(acc[0], block[i]);
+  });
+  if (first) return empty_value;
+  T result = acc[0];
+  for (T a : acc) result = pick(result, a);
+  return result;
+}
+
+}  // namespace detail
+
+// The smallest element, or empty_value if the range is empty.
+template <class Range>
+auto min(const Range& r,
+         detail::arithmetic_range_value_t<Range> empty_value = {}) {
+  using T = detail::arithmetic_range_value_t<Range>;
+  return detail::lane_fold(r, empty_value,
+                           [](T a, T b) { return b < a ? b : a; });
+}
+
+// The largest element, or empty_value if the range is empty.
+template <class Range>
+auto max(const Range& r,
+         detail::arithmetic_range_value_t<Range> empty_value = {}) {
+  using T = detail::arithmetic_range_value_t<Range>;
+  return detail::lane_fold(r, empty_value,
+                           [](T a, T b) { return a < b ? b : a; });
+}
+
+// Whether two objects of type T compare equal exactly when their object
+// representations are equal, so that operator== can be replaced by memcmp.
+// This holds for integers, enumerations and pointers. For class types it
+// depends on T's operator== and cannot be detected; specialise this trait as
+// true for records whose members are all bytewise comparable, whose equality
+// compares every member and which have no padding.
+template <class T>
+struct is_bytewise_comparable
+    : std::bool_constant<std::has_unique_object_representations_v<T> &&
+                         !std::is_class_v<T> && !std::is_union_v<T>> {};
+
+template <class T>
+inline constexpr bool is_bytewise_comparable_v =
+    is_bytewise_comparable<T>::value;
+
+namespace detail {
+
+// The value type of a contiguous range of indirect_values. Substitution fails
+// for any other range.
+template <class Range, class Traits = indirect_value_traits<
+                           range_element_t<const Range>>>
+using indirect_range_value_t =
+    std::enable_if_t<Traits::is_indirect_value, typename Traits::value_type>;
+
+// How many elements ahead of the current one the pointees are prefetched.
+inline constexpr std::size_t prefetch_distance = 16;
+
+inline void prefetch(const void* p) noexcept {
+#if defined(__GNUC__) || defined(__clang__)
+  __builtin_prefetch(p);
+#else
+  (void)p;
+#endif
+}
+
+// Prefetches the pointee of element i + prefetch_distance of [first, last).
+template <class IV>
+void prefetch_ahead(const IV* first, std::size_t i, std::size_t n) noexcept {
+  if (i + prefetch_distance < n) {
+    prefetch(first[i + prefetch_distance].operator->());
+  }
+}
+
+template <class T, class U>
+inline constexpr bool bytewise_pair_v =
+    std::is_same_v<T, U> && is_bytewise_comparable_v<T>;
+
+template <class T, class U>
+bool pointees_equal(const T* a, const U* b) {
+  if (a == nullptr || b == nullptr) return a == b;
+  if constexpr (bytewise_pair_v<T, U>) {
+    return std::memcmp(a, b, sizeof(T)) == 0;
+  } else {
+    if (static_cast<const void*>(a) == static_cast<const void*>(b)) {
+      return true;
+    }
+    return *a == *b;
+  }
+}
+
+// Hashes the object representation eight bytes at a time. Objects of 32 bytes
+// or more are spread over four independent accumulators so that they are not
+// serialised on one multiply chain.
+inline std::uint64_t hash_bytes(const void* data, std::size_t n) noexcept {
+  constexpr std::uint64_t k0 = 0x9e3779b97f4a7c15ull;
+  constexpr std::uint64_t k1 = 0xc2b2ae3d27d4eb4full;
+  const auto* p = static_cast<const unsigned char*>(data);
+  auto word = [p](std::size_t i) {
+    std::uint64_t w;
+    std::memcpy(&w, p + i, 8);
+    return w;
+  };
+  auto mix = [](std::uint64_t h, std::uint64_t w) {
+    h = (h ^ w) * k1;
+    return h ^ (h >> 29);
+  };
+  std::uint64_t h = k0 ^ n;
+  std::size_t i = 0;
+  if (n >= 32) {
+    std::uint64_t acc[4] = {h, h ^ k1, h + k0, h - k1};
+    for (; i + 32 <= n; i += 32) {
+      for (std::size_t l = 0; l != 4; ++l) {
+        acc[l] = mix(acc[l], word(i + 8 * l));
+      }
+    }
+    h = (acc[0] + acc[1]) ^ ((acc[2] + acc[3]) * k0);
+  }
+  for (; i + 8 <= n; i += 8) h = mix(h, word(i));
+  if (i != n) {
+    std::uint64_t w = 0;
+    std::memcpy(&w, p + i, n - i);
+    h = mix(h, w);
+  }
+  h *= k0;
+  return h ^ (h >> 32);
+}
+
+inline std::size_t hash_combine(std::size_t seed, std::size_t h) noexcept {
+  return seed ^ (h + 0x9e3779b9u + (seed << 6) + (seed >> 2));
+}
+
+}  // namespace detail
+
+// Comparison and hashing of contiguous ranges of indirect_values, with the
+// same meaning as comparing or hashing the elements one at a time: empty
+// elements are equal to each other and order before any value. Pointees are
+// prefetched a few elements ahead, elements that share a pointee are not
+// compared, and pointees of bytewise comparable type are compared and hashed
+// as bytes.
+
+// Whether the two ranges have the same length and equal elements.
+template <class Range1, class Range2,
+          class T = detail::indirect_range_value_t<Range1>,
+          class U = detail::indirect_range_value_t<Range2>>
+bool ranges_equal(const Range1& a, const Range2& b) {
+  const std::size_t n = std::size(a);
+  if (n != std::size(b)) return false;
+  const auto* x = std::data(a);
+  const auto* y = std::data(b);
+  if (static_cast<const void*>(x) == static_cast<const void*>(y)) return true;
+  for (std::size_t i = 0; i != n; ++i) {
+    detail::prefetch_ahead(x, i, n);
+    detail::prefetch_ahead(y, i, n);
+    const T* p = x[i].operator->();
+    const U* q = y[i].operator->();
+    if (!detail::pointees_equal(p, q)) return false;
+  }
+  return true;
+}
+
+// Whether the first range orders before the second, like
+// std::lexicographical_compare over the elements. Elements with bytewise
+// equal pointees are skipped without calling operator<.
+template <class Range1, class Range2,
+          class T = detail::indirect_range_value_t<Range1>,
+          class U = detail::indirect_range_value_t<Range2>>
+bool lexicographical_compare(const Range1& a, const Range2& b) {
+  const std::size_t n = std::size(a);
+  const std::size_t m = std::size(b);
+  const std::size_t common = n < m ? n : m;
+  const auto* x = std::data(a);
+  const auto* y = std::data(b);
+  if (static_cast<const void*>(x) == static_cast<const void*>(y)) {
+    return false;
+  }
+  for (std::size_t i = 0; i != common; ++i) {
+    detail::prefetch_ahead(x, i, common);
+    detail::prefetch_ahead(y, i, common);
+    const T* p = x[i].operator->();
+    const U* q = y[i].operator->();
+    if (p == nullptr || q == nullptr) {
+      if (p != q) return p == nullptr;
+      continue;
+    }
+    if (static_cast<const void*>(p) == static_cast<const void*>(q)) continue;
+    if constexpr (detail::bytewise_pair_v<T, U>) {
+      if (std::memcmp(p, q, sizeof(T)) == 0) continue;
+    }
+    if (*p < *q) return true;
+    if (*q < *p) return false;
+  }
+  return n < m;
+}
+
+// A hash of the range such that ranges_equal ranges hash equally. Pointees of
+// bytewise comparable type are hashed as bytes; others use std::hash<T>.
+template <class Range, class T = detail::indirect_range_value_t<Range>>
+std::size_t hash_range(const Range& r) {
+  const std::size_t n = std::size(r);
+  const auto* x = std::data(r);
+  std::size_t seed = n;
+  for (std::size_t i = 0; i != n; ++i) {
+    detail::prefetch_ahead(x, i, n);
+    const T* p = x[i].operator->();
+    std::size_t h = 0;
+    if (p != nullptr) {
+      if constexpr (is_bytewise_comparable_v<T>) {
+        h = static_cast<std::size_t>(detail::hash_bytes(p, sizeof(T)));
+      } else {
+        h = std::hash<T>{}(*p);
+      }
+      // Keeps an empty element distinct from a value that hashes to 0.
+      h += 1;
+    }
+    seed = detail::hash_combine(seed, h);
+  }
+  return seed;
+}
+
+}  // namespace isocpp_p1950
+
+#endif  // ISOCPP_P1950_INDIRECT_VALUE_ALGORITHM_H
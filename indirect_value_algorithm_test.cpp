@@ -0,0 +1,223 @@
+/* Copyright (c) 2019 The Indirect Value Authors. All Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+==============================================================================*/
+
+#include "indirect_value_algorithm.h"
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "catch2/catch_template_test_macros.hpp"
+#include "catch2/catch_test_macros.hpp"
+
+using isocpp_p1950::indirect_value;
+using isocpp_p1950::make_indirect_value;
+namespace detail = isocpp_p1950::detail;
+
+namespace {
+// Every third element is empty.
+template <class T>
+std::vector<indirect_value<T>> make_values(std::size_t n) {
+  std::vector<indirect_value<T>> values(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    if (i % 3 != 1) values[i] = make_indirect_value<T>(static_cast<T>(i % 50));
+  }
+  return values;
+}
+
+bool isa_supported(detail::gather_isa isa) {
+  return static_cast<int>(isa) <= static_cast<int>(detail::best_gather_isa());
+}
+}  // namespace
+
+TEMPLATE_TEST_CASE("Gather kernels agree with the scalar loop",
+                   "[indirect_value_algorithm.gather_block]", float, double,
+                   int, std::int64_t) {
+  for (auto isa : {detail::gather_isa::scalar, detail::gather_isa::avx2,
+                   detail::gather_isa::avx512}) {
+    if (!isa_supported(isa)) continue;
+    for (std::size_t n : {0, 1, 3, 4, 7, 8, 9, 31, 64}) {
+      const auto values = make_values<TestType>(n);
+      std::vector<TestType> out(n);
+      detail::gather_block(values.data(), n, out.data(), TestType(-1), isa);
+      for (std::size_t i = 0; i < n; ++i) {
+        REQUIRE(out[i] == (values[i] ? *values[i] : TestType(-1)));
+      }
+    }
+  }
+}
+
+TEMPLATE_TEST_CASE("Reductions over ranges of indirect_value",
+                   "[indirect_value_algorithm.reduce]", float, double, int) {
+  const auto values = make_values<TestType>(1000);
+  TestType expected_sum = 0;
+  TestType expected_min = 100;
+  TestType expected_max = -100;
+  int expected_positive = 0;
+  for (const auto& v : values) {
+    const TestType x = v ? *v : TestType(-2);
+    expected_sum += x;
+    expected_positive += x > 0 ? 1 : 0;
+    expected_min = std::min(expected_min, x);
+    expected_max = std::max(expected_max, x);
+  }
+
+  REQUIRE(std::abs(isocpp_p1950::sum(values, TestType(-2)) - expected_sum) <=
+          TestType(1e-3) * std::abs(expected_sum));
+  REQUIRE(isocpp_p1950::min(values, TestType(-2)) == expected_min);
+  REQUIRE(isocpp_p1950::max(values, TestType(-2)) == expected_max);
+  REQUIRE(isocpp_p1950::transform_reduce(
+              values, 0, [](int a, int b) { return a + b; },
+              [](TestType x) { return x > 0 ? 1 : 0; },
+              TestType(-2)) == expected_positive);
+}
+
+TEST_CASE("Reductions over an empty range return the empty value",
+          "[indirect_value_algorithm.empty_range]") {
+  const std::vector<indirect_value<double>> none;
+  REQUIRE(isocpp_p1950::sum(none) == 0.0);
+  REQUIRE(isocpp_p1950::min(none, 3.0) == 3.0);
+  REQUIRE(isocpp_p1950::max(none, 4.0) == 4.0);
+}
+
+TEST_CASE("Gather into an output iterator",
+          "[indirect_value_algorithm.gather]") {
+  std::array<indirect_value<double>, 3> values = {
+      make_indirect_value<double>(1.5), indirect_value<double>(),
+      make_indirect_value<double>(2.5)};
+  std::vector<double> out;
+  isocpp_p1950::gather(values, std::back_inserter(out), 9.0);
+  REQUIRE(out == std::vector<double>{1.5, 9.0, 2.5});
+}
+
+namespace {
+struct record {
+  std::uint32_t id;
+  std::uint32_t parent;
+  std::uint64_t offset;
+
+  friend bool operator==(const record& a, const record& b) {
+    return a.id == b.id && a.parent == b.parent && a.offset == b.offset;
+  }
+  friend bool operator<(const record& a, const record& b) {
+    if (a.id != b.id) return a.id < b.id;
+    if (a.parent != b.parent) return a.parent < b.parent;
+    return a.offset < b.offset;
+  }
+};
+}  // namespace
+
+template <>
+struct isocpp_p1950::is_bytewise_comparable<record> : std::true_type {};
+
+namespace {
+template <class T>
+T make_test_value(std::size_t i) {
+  if constexpr (std::is_same_v<T, record>) {
+    return record{static_cast<std::uint32_t>(i % 7),
+                  static_cast<std::uint32_t>(i % 3), i % 5};
+  } else {
+    return static_cast<T>(i % 11);
+  }
+}
+
+template <class T>
+std::vector<indirect_value<T>> make_test_range(std::size_t n) {
+  std::vector<indirect_value<T>> values(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    if (i % 4 != 3) values[i] = make_indirect_value<T>(make_test_value<T>(i));
+  }
+  return values;
+}
+}  // namespace
+
+TEST_CASE("Bytewise comparability is detected for scalars only",
+          "[indirect_value_algorithm.is_bytewise_comparable]") {
+  STATIC_REQUIRE(isocpp_p1950::is_bytewise_comparable_v<int>);
+  STATIC_REQUIRE(isocpp_p1950::is_bytewise_comparable_v<std::uint64_t>);
+  STATIC_REQUIRE(isocpp_p1950::is_bytewise_comparable_v<const int*>);
+  STATIC_REQUIRE(!isocpp_p1950::is_bytewise_comparable_v<float>);
+  STATIC_REQUIRE(!isocpp_p1950::is_bytewise_comparable_v<double>);
+  STATIC_REQUIRE(!isocpp_p1950::is_bytewise_comparable_v<std::array<int, 2>>);
+  STATIC_REQUIRE(isocpp_p1950::is_bytewise_comparable_v<record>);
+}
+
+template <class T>
+bool expected_less(const std::vector<indirect_value<T>>& a,
+                   const std::vector<indirect_value<T>>& b) {
+  return std::lexicographical_compare(
+      a.begin(), a.end(), b.begin(), b.end(),
+      [](const indirect_value<T>& x, const indirect_value<T>& y) {
+        if (!y) return false;
+        if (!x) return true;
+        return *x < *y;
+      });
+}
+
+TEMPLATE_TEST_CASE("Range comparisons agree with element-wise comparisons",
+                   "[indirect_value_algorithm.ranges_equal]", int, double,
+                   record) {
+  for (std::size_t n : {0, 1, 5, 16, 33}) {
+    const auto a = make_test_range<TestType>(n);
+    auto b = make_test_range<TestType>(n);
+    const auto longer = make_test_range<TestType>(n + 1);
+
+    REQUIRE(isocpp_p1950::ranges_equal(a, b));
+    REQUIRE(isocpp_p1950::ranges_equal(a, a));
+    REQUIRE(!isocpp_p1950::lexicographical_compare(a, b));
+    REQUIRE(!isocpp_p1950::lexicographical_compare(b, a));
+    REQUIRE(isocpp_p1950::hash_range(a) == isocpp_p1950::hash_range(b));
+
+    REQUIRE(!isocpp_p1950::ranges_equal(a, longer));
+    REQUIRE(isocpp_p1950::lexicographical_compare(a, longer));
+    REQUIRE(!isocpp_p1950::lexicographical_compare(longer, a));
+
+    for (std::size_t i = 0; i < n; ++i) {
+      b = make_test_range<TestType>(n);
+      if (b[i]) {
+        b[i] = indirect_value<TestType>();
+      } else {
+        b[i] = make_indirect_value<TestType>(make_test_value<TestType>(i));
+      }
+      REQUIRE(!isocpp_p1950::ranges_equal(a, b));
+      REQUIRE(isocpp_p1950::lexicographical_compare(a, b) ==
+              expected_less(a, b));
+      REQUIRE(isocpp_p1950::lexicographical_compare(b, a) ==
+              expected_less(b, a));
+      REQUIRE(isocpp_p1950::hash_range(a) != isocpp_p1950::hash_range(b));
+    }
+  }
+}
+
+TEST_CASE("Range comparisons of floating point use operator==",
+          "[indirect_value_algorithm.ranges_equal]") {
+  std::vector<indirect_value<double>> a;
+  std::vector<indirect_value<double>> b;
+  a.push_back(make_indirect_value<double>(0.0));
+  b.push_back(make_indirect_value<double>(-0.0));
+  REQUIRE(isocpp_p1950::ranges_equal(a, b));
+  REQUIRE(!isocpp_p1950::lexicographical_compare(a, b));
+  REQUIRE(!isocpp_p1950::lexicographical_compare(b, a));
+
+  a.push_back(make_indirect_value<double>(std::nan("")));
+  b.push_back(make_indirect_value<double>(std::nan("")));
+  REQUIRE(!isocpp_p1950::ranges_equal(a, b));
+}
@@ -0,0 +1,270 @@
+/* Copyright (c) 2019 The Indirect Value Authors. All Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+==============================================================================*/
+
+#ifndef ISOCPP_P1950_INDIRECT_VALUE_COMPACTION_H
+#define ISOCPP_P1950_INDIRECT_VALUE_COMPACTION_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "indirect_value.h"
+
+namespace isocpp_p1950 {
+
+// A bump allocator whose blocks are released as soon as nothing allocated from
+// them is still alive.
+//
+// Consecutive allocations are laid out contiguously in allocation order, and
+// reserve() guarantees that the next allocations up to a given size share a
+// single block. This is the layout compact() relies on. Each allocation is
+// preceded by a pointer to its block, so deallocation is constant time.
+//
+// The arena is not thread-safe, and it must outlive every allocation made
+// from it.
+class compaction_arena {
+  struct block {
+    block* prev;
+    block* next;
+    std::size_t live;
+    std::size_t size;
+  };
+
+ public:
+  static constexpr std::size_t default_block_size = 64 * 1024;
+
+  explicit compaction_arena(std::size_t block_size = default_block_size)
+      : block_size_(block_size) {}
+
+  compaction_arena(const compaction_arena&) = delete;
+  compaction_arena& operator=(const compaction_arena&) = delete;
+
+  ~compaction_arena() {
+    while (blocks_) release_block(blocks_);
+  }
+
+  void* allocate(std::size_t bytes, std::size_t alignment) {
+    std::size_t offset = offset_for(cursor_, alignment);
+    if (!current_ || offset + bytes > current_->size) {
+      start_block(bytes + alignment + sizeof(block*));
+      offset = offset_for(cursor_, alignment);
+    }
+    auto* base = reinterpret_cast<unsigned char*>(current_);
+    ::new (base + offset - sizeof(block*)) block*(current_);
+    cursor_ = offset + bytes;
+    ++current_->live;
+    return base + offset;
+  }
+
+  void deallocate(void* p) noexcept {
+    auto* header = static_cast<unsigned char*>(p) - sizeof(block*);
+    block* b = *std::launder(reinterpret_cast<block**>(header));
+    if (--b->live == 0 && b != current_) release_block(b);
+  }
+
+  // Ensures that the next allocations totalling up to `bytes`, including
+  // per-allocation overhead, are placed contiguously in one block.
+  void reserve(std::size_t bytes) {
+    if (!current_ || cursor_ + bytes > current_->size) start_block(bytes);
+  }
+
+  // The space one allocation of `bytes` with the given alignment may take,
+  // for use with reserve().
+  static constexpr std::size_t footprint(std::size_t bytes,
+                                         std::size_t alignment) noexcept {
+    return bytes + sizeof(block*) + alignment;
+  }
+
+  // Whether p points into one of the blocks currently held.
+  bool contains(const void* p) const noexcept {
+    const auto address = reinterpret_cast<std::uintptr_t>(p);
+    for (block* b = blocks_; b; b = b->next) {
+      const auto base = reinterpret_cast<std::uintptr_t>(b);
+      if (address >= base && address < base + b->size) return true;
+    }
+    return false;
+  }
+
+  // The number of blocks currently held.
+  std::size_t block_count() const noexcept {
+    std::size_t n = 0;
+    for (block* b = blocks_; b; b = b->next) ++n;
+    return n;
+  }
+
+ private:
+  // The offset in the current block at which an allocation with the given
+  // alignment, preceded by its block pointer, can be placed.
+  std::size_t offset_for(std::size_t cursor,
+                         std::size_t alignment) const noexcept {
+    const auto base = reinterpret_cast<std::uintptr_t>(current_);
+    const std::uintptr_t first = base + cursor + sizeof(block*);
+    const std::uintptr_t aligned =
+        (first + alignment - 1) / alignment * alignment;
+    return static_cast<std::size_t>(aligned - base);
+  }
+
+  void start_block(std::size_t min_bytes) {
+    const std::size_t size =
+        std::max(block_size_, min_bytes + sizeof(block));
+    block* previous = current_;
+    auto* b = ::new (::operator new(size)) block{nullptr, blocks_, 0, size};
+    if (blocks_) blocks_->prev = b;
+    blocks_ = b;
+    current_ = b;
+    cursor_ = sizeof(block);
+    // The previous block was kept while allocations could still be added.
+    if (previous && previous->live == 0) release_block(previous);
+  }
+
+  void release_block(block* b) noexcept {
+    if (b->prev) b->prev->next = b->next;
+    if (b->next) b->next->prev = b->prev;
+    if (blocks_ == b) blocks_ = b->next;
+    if (current_ == b) current_ = nullptr;
+    b->~block();
+    ::operator delete(static_cast<void*>(b));
+  }
+
+  std::size_t block_size_;
+  block* blocks_ = nullptr;
+  block* current_ = nullptr;
+  std::size_t cursor_ = 0;
+};
+
+// An allocator that obtains memory from a compaction_arena.
+template <class T>
+class arena_allocator {
+ public:
+  using value_type = T;
+
+  explicit arena_allocator(compaction_arena& arena) noexcept
+      : arena_(&arena) {}
+
+  template <class U>
+  arena_allocator(const arena_allocator<U>& other) noexcept
+      : arena_(&other.arena()) {}
+
+  T* allocate(std::size_t n) {
+    return static_cast<T*>(arena_->allocate(n * sizeof(T), alignof(T)));
+  }
+
+  void deallocate(T* p, std::size_t) noexcept { arena_->deallocate(p); }
+
+  // Ensures that the next n single-object allocations are contiguous.
+  void reserve(std::size_t n) {
+    arena_->reserve(n * compaction_arena::footprint(sizeof(T), alignof(T)));
+  }
+
+  compaction_arena& arena() const noexcept { return *arena_; }
+
+  template <class U>
+  friend bool operator==(const arena_allocator& lhs,
+                         const arena_allocator<U>& rhs) noexcept {
+    return &lhs.arena() == &rhs.arena();
+  }
+
+  template <class U>
+  friend bool operator!=(const arena_allocator& lhs,
+                         const arena_allocator<U>& rhs) noexcept {
+    return !(lhs == rhs);
+  }
+
+ private:
+  compaction_arena* arena_;
+};
+
+namespace detail {
+
+template <class A, class = void>
+struct has_reserve : std::false_type {};
+
+template <class A>
+struct has_reserve<A, std::void_t<decltype(std::declval<A&>().reserve(
+                          std::size_t{}))>> : std::true_type {};
+
+}  // namespace detail
+
+// Moves the pointees of the indirect_values in `r` into fresh storage from
+// `a`, in iteration order, and rebinds each element to its new pointee. The
+// old pointees are released through the elements' own deleters. With an
+// arena_allocator the relocated pointees are contiguous, restoring locality
+// for scans of the range.
+//
+// Elements must be the indirect_values created by allocate_indirect_value
+// with allocator type A. Empty elements are skipped. Compacted elements take
+// on `a` as their allocator, whether or not A propagates. A range of plain
+// indirect_value<T> cannot be compacted: its pointees are released with
+// delete, so they cannot be moved into storage from an allocator. Create the
+// values with allocate_indirect_value to make them compactable.
+//
+// At most `budget` pointees are moved, starting at element `first`, so that
+// the work can be spread over several calls. Returns the index at which to
+// resume; compaction is complete when that equals the size of the range.
+// The call with `first` equal to zero reserves room for the whole range, so
+// pointees remain contiguous across calls provided nothing else allocates
+// from the arena in between.
+template <class Range, class A>
+std::size_t compact(Range& r, A& a, std::size_t first = 0,
+                    std::size_t budget =
+                        std::numeric_limits<std::size_t>::max()) {
+  using element = std::remove_reference_t<decltype(*std::begin(r))>;
+  using T = typename element::value_type;
+  static_assert(
+      std::is_same_v<element, indirect_value<T, detail::allocator_copy<T, A>,
+                                             detail::allocator_delete<T, A>>>,
+      "compact requires indirect_values created by allocate_indirect_value "
+      "with the same allocator type");
+
+  const auto size = static_cast<std::size_t>(std::distance(
+      std::begin(r), std::end(r)));
+  if (first >= size) return size;
+  const std::size_t count = std::min(budget, size - first);
+
+  if constexpr (detail::has_reserve<A>::value) {
+    // Reserving once for the whole range keeps later increments in the same
+    // block.
+    if (first == 0) a.reserve(size);
+  }
+
+  auto it = std::next(std::begin(r), first);
+  for (std::size_t i = 0; i != count; ++i, ++it) {
+    element& v = *it;
+    if (!v) continue;
+    auto fresh = allocate_indirect_value<T>(std::allocator_arg, a,
+                                            std::move_if_noexcept(*v));
+    // Assignment follows the allocator's propagation traits, and without
+    // propagation would move the pointee back into the old storage, so the
+    // element is rebuilt around the new allocator instead.
+    std::destroy_at(std::addressof(v));
+    ::new (static_cast<void*>(std::addressof(v))) element(std::move(fresh));
+  }
+  return first + count;
+}
+
+}  // namespace isocpp_p1950
+
+#endif  // ISOCPP_P1950_INDIRECT_VALUE_COMPACTION_H
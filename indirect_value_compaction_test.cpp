@@ -0,0 +1,199 @@
+/* Copyright (c) 2019 The Indirect Value Authors. All Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+==============================================================================*/
+
+#include "indirect_value_compaction.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "catch2/catch_test_macros.hpp"
+
+using isocpp_p1950::allocate_indirect_value;
+using isocpp_p1950::arena_allocator;
+using isocpp_p1950::compact;
+using isocpp_p1950::compaction_arena;
+
+namespace {
+
+template <class T>
+using arena_value = decltype(allocate_indirect_value<T>(
+    std::allocator_arg, std::declval<arena_allocator<T>&>()));
+
+struct Record {
+  int id;
+  double weight;
+};
+
+// Builds n values whose pointees are interleaved with other allocations and
+// then shuffled, so that neither address order nor adjacency is preserved.
+std::vector<arena_value<Record>> scattered(arena_allocator<Record>& a,
+                                           std::vector<void*>& padding,
+                                           int n) {
+  std::vector<arena_value<Record>> v;
+  for (int i = 0; i < n; ++i) {
+    v.push_back(allocate_indirect_value<Record>(std::allocator_arg, a,
+                                                Record{i, i * 0.5}));
+    padding.push_back(a.arena().allocate(24, 8));
+  }
+  std::reverse(v.begin(), v.end());
+  std::rotate(v.begin(), v.begin() + n / 3, v.end());
+  return v;
+}
+
+template <class Range>
+bool contiguous_in_order(const Range& r) {
+  const Record* previous = nullptr;
+  std::ptrdiff_t stride = 0;
+  for (const auto& e : r) {
+    const Record* p = &*e;
+    if (previous) {
+      const std::ptrdiff_t d = reinterpret_cast<const char*>(p) -
+                               reinterpret_cast<const char*>(previous);
+      if (d <= 0 || (stride != 0 && d != stride)) return false;
+      stride = d;
+    }
+    previous = p;
+  }
+  return true;
+}
+
+}  // namespace
+
+TEST_CASE("Compaction lays out pointees in iteration order",
+          "[compaction.order]") {
+  compaction_arena arena;
+  arena_allocator<Record> a(arena);
+  std::vector<void*> padding;
+  GIVEN("A range of values with scattered pointees") {
+    auto v = scattered(a, padding, 100);
+    std::vector<int> ids;
+    for (const auto& e : v) ids.push_back(e->id);
+    REQUIRE(!contiguous_in_order(v));
+
+    WHEN("The range is compacted") {
+      REQUIRE(compact(v, a) == v.size());
+      THEN("Pointees are contiguous, in order, with their values intact") {
+        REQUIRE(contiguous_in_order(v));
+        for (std::size_t i = 0; i < v.size(); ++i) {
+          REQUIRE(v[i]->id == ids[i]);
+          REQUIRE(v[i]->weight == ids[i] * 0.5);
+        }
+      }
+    }
+  }
+  for (void* p : padding) arena.deallocate(p);
+}
+
+TEST_CASE("Compaction runs within a budget", "[compaction.incremental]") {
+  compaction_arena arena;
+  arena_allocator<Record> a(arena);
+  std::vector<void*> padding;
+  auto v = scattered(a, padding, 50);
+  std::vector<int> ids;
+  for (const auto& e : v) ids.push_back(e->id);
+
+  std::size_t next = 0;
+  int steps = 0;
+  while (next != v.size()) {
+    const std::size_t resumed = next;
+    next = compact(v, a, next, 7);
+    REQUIRE(next - resumed <= 7);
+    ++steps;
+  }
+  REQUIRE(steps == 8);
+  REQUIRE(contiguous_in_order(v));
+  for (std::size_t i = 0; i < v.size(); ++i) REQUIRE(v[i]->id == ids[i]);
+  REQUIRE(compact(v, a, v.size(), 7) == v.size());
+  for (void* p : padding) arena.deallocate(p);
+}
+
+TEST_CASE("Compaction skips empty values", "[compaction.empty]") {
+  compaction_arena arena;
+  arena_allocator<std::string> a(arena);
+  std::vector<arena_value<std::string>> v;
+  v.push_back(allocate_indirect_value<std::string>(std::allocator_arg, a,
+                                                   "first"));
+  v.push_back(allocate_indirect_value<std::string>(std::allocator_arg, a,
+                                                   "second"));
+  v.push_back(allocate_indirect_value<std::string>(std::allocator_arg, a,
+                                                   "third"));
+  auto taken = std::move(v[1]);
+  compact(v, a);
+  REQUIRE(*v[0] == "first");
+  REQUIRE(!v[1]);
+  REQUIRE(*v[2] == "third");
+}
+
+TEST_CASE("Compaction moves pointees into another arena",
+          "[compaction.rebind]") {
+  compaction_arena first;
+  compaction_arena second;
+  arena_allocator<Record> from(first);
+  arena_allocator<Record> to(second);
+  std::vector<void*> padding;
+  auto v = scattered(from, padding, 50);
+
+  compact(v, to);
+  THEN("The pointees live in the new arena and use its allocator") {
+    REQUIRE(contiguous_in_order(v));
+    for (const auto& e : v) {
+      REQUIRE(second.contains(&*e));
+      REQUIRE(!first.contains(&*e));
+      REQUIRE(e.get_allocator() == to);
+    }
+  }
+  for (void* p : padding) first.deallocate(p);
+}
+
+TEST_CASE("Compaction releases the blocks it empties",
+          "[compaction.release]") {
+  compaction_arena arena(1024);
+  arena_allocator<Record> a(arena);
+  std::vector<arena_value<Record>> v;
+  for (int i = 0; i < 200; ++i) {
+    v.push_back(allocate_indirect_value<Record>(std::allocator_arg, a,
+                                                Record{i, 0.0}));
+  }
+  const std::size_t before = arena.block_count();
+  REQUIRE(before > 1);
+
+  compact(v, a);
+  THEN("Only the block holding the compacted pointees remains") {
+    REQUIRE(arena.block_count() == 1);
+  }
+  v.clear();
+  REQUIRE(arena.block_count() == 1);
+}
+
+TEST_CASE("arena_allocator compares equal when sharing an arena",
+          "[compaction.allocator]") {
+  compaction_arena first;
+  compaction_arena second;
+  arena_allocator<int> a(first);
+  arena_allocator<double> b(first);
+  arena_allocator<int> c(second);
+  REQUIRE(a == b);
+  REQUIRE(a != c);
+  REQUIRE(&arena_allocator<double>(a).arena() == &first);
+}
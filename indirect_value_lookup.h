@@ -0,0 +1,105 @@
+/* Copyright (c) 2019 The Indirect Value Authors. All Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+==============================================================================*/
+
+#ifndef ISOCPP_P1950_INDIRECT_VALUE_LOOKUP_H
+#define ISOCPP_P1950_INDIRECT_VALUE_LOOKUP_H
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#include "indirect_value.h"
+
+namespace isocpp_p1950 {
+
+namespace detail {
+
+template <class T, class U, class = void>
+struct is_string_view_key : std::false_type {};
+
+// A string key can be looked up by anything convertible to its string_view,
+// because std::hash gives a basic_string and the equal basic_string_view the
+// same hash.
+template <class CharT, class Traits, class A, class U>
+struct is_string_view_key<std::basic_string<CharT, Traits, A>, U>
+    : std::is_convertible<const U&, std::basic_string_view<CharT, Traits>> {
+};
+
+}  // namespace detail
+
+// Transparent hash for containers keyed by indirect_value<T>.
+//
+// An indirect_value hashes as std::hash<indirect_value<T>> does: the hash of
+// the pointee, or zero when empty. A T hashes as std::hash<T>, so a lookup by
+// T finds the equal indirect_value without building a temporary one. For
+// string keys, string_view-like arguments such as std::string_view and
+// character pointers are also accepted.
+template <class T>
+struct indirect_value_hash {
+  using is_transparent = void;
+
+  template <class C, class D>
+  std::size_t operator()(const indirect_value<T, C, D>& key) const
+      noexcept(noexcept(std::hash<T>{}(*key))) {
+    return key ? std::hash<T>{}(*key) : 0;
+  }
+
+  std::size_t operator()(const T& key) const
+      noexcept(noexcept(std::hash<T>{}(key))) {
+    return std::hash<T>{}(key);
+  }
+
+  template <class U, class = std::enable_if_t<
+                         detail::is_string_view_key<T, U>::value &&
+                         !std::is_same_v<U, T>>>
+  std::size_t operator()(const U& key) const noexcept {
+    using view = std::basic_string_view<typename T::value_type,
+                                        typename T::traits_type>;
+    return std::hash<view>{}(view(key));
+  }
+};
+
+// Transparent equality with the semantics of the mixed relational operators:
+// an empty indirect_value equals only another empty one.
+struct indirect_value_equal_to {
+  using is_transparent = void;
+
+  template <class L, class R>
+  constexpr bool operator()(const L& lhs, const R& rhs) const {
+    return lhs == rhs;
+  }
+};
+
+// Transparent ordering with the semantics of the mixed relational operators:
+// an empty indirect_value orders before every value.
+struct indirect_value_less {
+  using is_transparent = void;
+
+  template <class L, class R>
+  constexpr bool operator()(const L& lhs, const R& rhs) const {
+    return lhs < rhs;
+  }
+};
+
+}  // namespace isocpp_p1950
+
+#endif  // ISOCPP_P1950_INDIRECT_VALUE_LOOKUP_H
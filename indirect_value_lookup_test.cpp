@@ -0,0 +1,124 @@
+/* Copyright (c) 2019 The Indirect Value Authors. All Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+==============================================================================*/
+
+#include "indirect_value_lookup.h"
+
+#include <functional>
+#include <set>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+
+#include "allocation_counting.h"
+#include "catch2/catch_test_macros.hpp"
+
+using isocpp_p1950::indirect_value;
+using isocpp_p1950::indirect_value_equal_to;
+using isocpp_p1950::indirect_value_hash;
+using isocpp_p1950::indirect_value_less;
+using isocpp_p1950::make_indirect_value;
+using isocpp_p1950::testing::count_allocations;
+
+namespace {
+// Long enough that std::string stores it on the heap.
+const std::string long_key = "a key which does not fit in the small buffer";
+}  // namespace
+
+TEST_CASE("indirect_value_hash is consistent across key types",
+          "[indirect_value_lookup.hash]") {
+  const indirect_value_hash<std::string> hash;
+  const auto iv = make_indirect_value<std::string>(long_key);
+  const std::size_t expected = std::hash<std::string>{}(long_key);
+
+  REQUIRE(hash(iv) == expected);
+  REQUIRE(hash(iv) == std::hash<indirect_value<std::string>>{}(iv));
+  REQUIRE(hash(long_key) == expected);
+  REQUIRE(hash(std::string_view(long_key)) == expected);
+  REQUIRE(hash(long_key.c_str()) == expected);
+  REQUIRE(hash(indirect_value<std::string>()) ==
+          std::hash<indirect_value<std::string>>{}(
+              indirect_value<std::string>()));
+}
+
+TEST_CASE("indirect_value_equal_to and indirect_value_less are transparent",
+          "[indirect_value_lookup.compare]") {
+  const indirect_value_equal_to eq;
+  const indirect_value_less less;
+  const auto a = make_indirect_value<std::string>("a");
+  const auto b = make_indirect_value<std::string>("b");
+  const indirect_value<std::string> empty;
+
+  REQUIRE(eq(a, std::string_view("a")));
+  REQUIRE(eq(std::string("b"), b));
+  REQUIRE(!eq(empty, std::string_view("")));
+  REQUIRE(eq(empty, indirect_value<std::string>()));
+
+  REQUIRE(less(a, b));
+  REQUIRE(less(a, std::string_view("b")));
+  REQUIRE(less(std::string("a"), b));
+  REQUIRE(less(empty, std::string_view("")));
+  REQUIRE(!less(std::string_view(""), empty));
+}
+
+TEST_CASE("Ordered containers of indirect_value are searched without "
+          "allocating",
+          "[indirect_value_lookup.set]") {
+  std::set<indirect_value<std::string>, indirect_value_less> keys;
+  keys.insert(make_indirect_value<std::string>(long_key));
+  keys.insert(make_indirect_value<std::string>("other"));
+
+  bool found_by_string = false;
+  bool found_by_view = false;
+  bool found_missing = true;
+  const auto counts = count_allocations([&] {
+    found_by_string = keys.find(long_key) != keys.end();
+    found_by_view = keys.count(std::string_view(long_key)) == 1;
+    found_missing = keys.find(std::string_view("missing")) != keys.end();
+  });
+  REQUIRE(found_by_string);
+  REQUIRE(found_by_view);
+  REQUIRE(!found_missing);
+  REQUIRE(counts.allocations == 0);
+}
+
+#if defined(__cpp_lib_generic_unordered_lookup)
+TEST_CASE("Unordered containers of indirect_value are searched without "
+          "allocating",
+          "[indirect_value_lookup.unordered_set]") {
+  std::unordered_set<indirect_value<std::string>,
+                     indirect_value_hash<std::string>, indirect_value_equal_to>
+      keys;
+  keys.insert(make_indirect_value<std::string>(long_key));
+  keys.insert(make_indirect_value<std::string>("other"));
+
+  bool found_by_string = false;
+  bool found_by_view = false;
+  bool found_missing = true;
+  const auto counts = count_allocations([&] {
+    found_by_string = keys.find(long_key) != keys.end();
+    found_by_view = keys.count(std::string_view(long_key)) == 1;
+    found_missing = keys.contains(std::string_view("missing"));
+  });
+  REQUIRE(found_by_string);
+  REQUIRE(found_by_view);
+  REQUIRE(!found_missing);
+  REQUIRE(counts.allocations == 0);
+}
+#endif
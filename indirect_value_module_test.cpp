@@ -0,0 +1,79 @@
+/* Copyright (c) 2019 The Indirect Value Authors. All Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+==============================================================================*/
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include "catch2/catch_test_macros.hpp"
+
+import isocpp_p1950.indirect_value;
+
+using isocpp_p1950::indirect_value;
+using isocpp_p1950::make_indirect_value;
+
+// Defined in indirect_value_module_include.cpp, which includes the header.
+indirect_value<std::string> make_value_from_header(const char* s);
+bool holds_value_from_header(const indirect_value<std::string>& v,
+                             const char* s);
+
+TEST_CASE("indirect_value is usable through import",
+          "[indirect_value.module]") {
+  STATIC_REQUIRE(sizeof(indirect_value<int>) == sizeof(int*));
+
+  GIVEN("A value created through the module") {
+    auto v = make_indirect_value<std::string>("module");
+    THEN("It deep copies and compares like the header version") {
+      auto copy = v;
+      REQUIRE(&*copy != &*v);
+      REQUIRE(copy == v);
+      REQUIRE(copy <= v);
+      REQUIRE(v < make_indirect_value<std::string>("module+"));
+      REQUIRE(v != nullptr);
+      REQUIRE(std::hash<indirect_value<std::string>>{}(v) ==
+              std::hash<std::string>{}("module"));
+    }
+    THEN("Empty values report bad access") {
+      indirect_value<int> empty;
+      REQUIRE(!empty.has_value());
+      // Macros defined by the header do not cross import, so repeat its
+      // detection here rather than relying on ISOCPP_P1950_NO_EXCEPTIONS
+      // having been defined for us.
+#if !defined(ISOCPP_P1950_NO_EXCEPTIONS) &&                              \
+    (defined(__cpp_exceptions) || defined(__EXCEPTIONS) || defined(_CPPUNWIND))
+      REQUIRE_THROWS_AS(empty.value(), isocpp_p1950::bad_indirect_value_access);
+#endif
+    }
+  }
+}
+
+TEST_CASE("Imported and included indirect_value are the same entity",
+          "[indirect_value.module]") {
+  auto from_header = make_value_from_header("header");
+  REQUIRE(*from_header == "header");
+
+  auto from_module = make_indirect_value<std::string>("module");
+  REQUIRE(holds_value_from_header(from_module, "module"));
+
+  from_header = std::move(from_module);
+  REQUIRE(holds_value_from_header(from_header, "module"));
+}
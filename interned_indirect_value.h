@@ -0,0 +1,295 @@
+/* Copyright (c) 2019 The Indirect Value Authors. All Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+==============================================================================*/
+
+#ifndef ISOCPP_P1950_INTERNED_INDIRECT_VALUE_H
+#define ISOCPP_P1950_INTERNED_INDIRECT_VALUE_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+
+#include "indirect_value.h"
+
+namespace isocpp_p1950 {
+
+// The process-wide table of distinct values shared by every
+// interned_indirect_value<T, Hash, KeyEqual>.
+//
+// Each distinct value is stored once, in a node with a reference count. The
+// table is sharded by hash so that threads interning concurrently rarely
+// contend. A node is removed when its last reference is released; the final
+// decrement is made under the shard lock so that a concurrent lookup cannot
+// revive a node that is being destroyed.
+template <class T, class Hash = std::hash<T>,
+          class KeyEqual = std::equal_to<T>>
+class intern_table {
+ public:
+  struct node {
+    template <class... Ts>
+    explicit node(std::size_t h, Ts&&... ts)
+        : value(std::forward<Ts>(ts)...), hash(h) {}
+
+    const T value;
+    const std::size_t hash;
+    std::atomic<std::size_t> references{1};
+  };
+
+  // Returns the node holding a value equal to `value`, with its reference
+  // count incremented, or a new node holding `value` moved from.
+  static node* intern(T&& value) { return find_or_insert(std::move(value)); }
+
+  static node* intern(const T& value) { return find_or_insert(value); }
+
+  // Adds a reference to a node the caller already holds a reference to.
+  static node* retain(node* n) noexcept {
+    n->references.fetch_add(1, std::memory_order_relaxed);
+    return n;
+  }
+
+  // Drops a reference, destroying the node when it was the last one.
+  static void release(node* n) noexcept {
+    std::size_t count = n->references.load(std::memory_order_relaxed);
+    while (count > 1) {
+      if (n->references.compare_exchange_weak(count, count - 1,
+                                               std::memory_order_release,
+                                               std::memory_order_relaxed)) {
+        return;
+      }
+    }
+    auto& s = shard_for(n->hash);
+    {
+      std::lock_guard<std::mutex> lock(s.mutex);
+      if (n->references.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+      auto range = s.nodes.equal_range(n->hash);
+      for (auto it = range.first; it != range.second; ++it) {
+        if (it->second == n) {
+          s.nodes.erase(it);
+          break;
+        }
+      }
+    }
+    delete n;
+  }
+
+  // The number of distinct values currently interned.
+  static std::size_t size() {
+    std::size_t n = 0;
+    for (auto& s : shards()) {
+      std::lock_guard<std::mutex> lock(s.mutex);
+      n += s.nodes.size();
+    }
+    return n;
+  }
+
+ private:
+  struct shard {
+    std::mutex mutex;
+    std::unordered_multimap<std::size_t, node*> nodes;
+  };
+
+  static constexpr std::size_t shard_count = 16;
+
+  // The shards are never destroyed, so that interned values with static
+  // storage duration can still release their nodes during program exit.
+  static std::array<shard, shard_count>& shards() noexcept {
+    static auto* instance = new std::array<shard, shard_count>;
+    return *instance;
+  }
+
+  static shard& shard_for(std::size_t hash) noexcept {
+    // std::hash is the identity for integers, so mix before picking a shard.
+    const auto h = static_cast<std::uint64_t>(hash) * 0x9e3779b97f4a7c15ull;
+    return shards()[(h >> 59) % shard_count];
+  }
+
+  template <class U>
+  static node* find_or_insert(U&& value) {
+    const std::size_t hash = Hash{}(value);
+    auto& s = shard_for(hash);
+    std::lock_guard<std::mutex> lock(s.mutex);
+    auto range = s.nodes.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it) {
+      if (KeyEqual{}(it->second->value, value)) return retain(it->second);
+    }
+    node* n = detail::new_object<node>(hash, std::forward<U>(value));
+    ISOCPP_P1950_TRY { s.nodes.emplace(hash, n); }
+    ISOCPP_P1950_CATCH_ALL {
+      delete n;
+      ISOCPP_P1950_RETHROW;
+    }
+    return n;
+  }
+};
+
+// A value-semantic handle to an immutable T that is shared with every other
+// interned_indirect_value holding an equal value.
+//
+// Values are deduplicated through intern_table using Hash and KeyEqual, by
+// default T's std::hash specialisation and operator==. Copying only
+// increments a reference count, and two interned values are equal exactly
+// when they share a node, so comparison and hashing do not touch T. The
+// pointee is only reachable as const; modify() applies a change to a private
+// copy and interns the result, leaving other holders of the old value
+// unaffected.
+//
+// Like indirect_value, a default constructed interned_indirect_value is
+// empty.
+template <class T, class Hash = std::hash<T>,
+          class KeyEqual = std::equal_to<T>>
+class interned_indirect_value {
+  using table = intern_table<T, Hash, KeyEqual>;
+  using node = typename table::node;
+
+  node* node_ = nullptr;
+
+ public:
+  using value_type = T;
+  using hasher = Hash;
+  using key_equal = KeyEqual;
+
+  constexpr interned_indirect_value() noexcept = default;
+
+  template <class... Ts>
+  explicit interned_indirect_value(std::in_place_t, Ts&&... ts)
+      : node_(table::intern(T(std::forward<Ts>(ts)...))) {}
+
+  explicit interned_indirect_value(const T& value)
+      : node_(table::intern(value)) {}
+
+  explicit interned_indirect_value(T&& value)
+      : node_(table::intern(std::move(value))) {}
+
+  // Interns the value of an indirect_value; an empty one gives an empty
+  // interned_indirect_value.
+  template <class C, class D>
+  explicit interned_indirect_value(const indirect_value<T, C, D>& v)
+      : node_(v ? table::intern(*v) : nullptr) {}
+
+  interned_indirect_value(const interned_indirect_value& other) noexcept
+      : node_(other.node_ ? table::retain(other.node_) : nullptr) {}
+
+  interned_indirect_value(interned_indirect_value&& other) noexcept
+      : node_(std::exchange(other.node_, nullptr)) {}
+
+  interned_indirect_value& operator=(
+      const interned_indirect_value& other) noexcept {
+    interned_indirect_value(other).swap(*this);
+    return *this;
+  }
+
+  interned_indirect_value& operator=(interned_indirect_value&& other) noexcept {
+    interned_indirect_value(std::move(other)).swap(*this);
+    return *this;
+  }
+
+  ~interned_indirect_value() {
+    if (node_) table::release(node_);
+  }
+
+  const T& operator*() const noexcept { return node_->value; }
+
+  const T* operator->() const noexcept { return &node_->value; }
+
+  const T& value() const {
+    if (!node_) detail::handle_bad_access();
+    return node_->value;
+  }
+
+  bool has_value() const noexcept { return node_ != nullptr; }
+
+  explicit operator bool() const noexcept { return node_ != nullptr; }
+
+  // Replaces the value with `f` applied to a copy of it, and returns the new
+  // value. The copy is interned afterwards, so other holders of the old value
+  // do not see the change. Requires a value.
+  template <class F>
+  const T& modify(F&& f) {
+    T copy(node_->value);
+    std::forward<F>(f)(copy);
+    interned_indirect_value(std::move(copy)).swap(*this);
+    return node_->value;
+  }
+
+  // Destroys the current value, if any, and interns T(ts...).
+  template <class... Ts>
+  const T& emplace(Ts&&... ts) {
+    interned_indirect_value(std::in_place, std::forward<Ts>(ts)...)
+        .swap(*this);
+    return node_->value;
+  }
+
+  // The number of interned_indirect_values sharing this value, or zero if
+  // empty. Other threads may change the count concurrently.
+  std::size_t use_count() const noexcept {
+    return node_ ? node_->references.load(std::memory_order_relaxed) : 0;
+  }
+
+  // The hash of the value, computed once when it was interned.
+  std::size_t hash() const noexcept { return node_ ? node_->hash : 0; }
+
+  void swap(interned_indirect_value& other) noexcept {
+    std::swap(node_, other.node_);
+  }
+
+  friend void swap(interned_indirect_value& lhs,
+                   interned_indirect_value& rhs) noexcept {
+    lhs.swap(rhs);
+  }
+
+  // Interned values are equal exactly when they share a node.
+  friend bool operator==(const interned_indirect_value& lhs,
+                         const interned_indirect_value& rhs) noexcept {
+    return lhs.node_ == rhs.node_;
+  }
+
+  friend bool operator!=(const interned_indirect_value& lhs,
+                         const interned_indirect_value& rhs) noexcept {
+    return lhs.node_ != rhs.node_;
+  }
+
+  // The number of distinct values interned for this T, Hash and KeyEqual.
+  static std::size_t interned_count() { return table::size(); }
+};
+
+template <class T, class... Ts>
+interned_indirect_value<T> make_interned_indirect_value(Ts&&... ts) {
+  return interned_indirect_value<T>(std::in_place, std::forward<Ts>(ts)...);
+}
+
+}  // namespace isocpp_p1950
+
+namespace std {
+template <class T, class Hash, class KeyEqual>
+struct hash<::isocpp_p1950::interned_indirect_value<T, Hash, KeyEqual>> {
+  size_t operator()(
+      const ::isocpp_p1950::interned_indirect_value<T, Hash, KeyEqual>& v)
+      const noexcept {
+    return v.hash();
+  }
+};
+}  // namespace std
+
+#endif  // ISOCPP_P1950_INTERNED_INDIRECT_VALUE_H
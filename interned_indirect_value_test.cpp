@@ -0,0 +1,191 @@
+/* Copyright (c) 2019 The Indirect Value Authors. All Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+==============================================================================*/
+
+#include "interned_indirect_value.h"
+
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "catch2/catch_test_macros.hpp"
+
+using isocpp_p1950::indirect_value;
+using isocpp_p1950::interned_indirect_value;
+using isocpp_p1950::make_indirect_value;
+using isocpp_p1950::make_interned_indirect_value;
+
+namespace {
+struct Descriptor {
+  std::string name;
+  int version = 0;
+
+  friend bool operator==(const Descriptor& a, const Descriptor& b) {
+    return a.name == b.name && a.version == b.version;
+  }
+};
+
+struct DescriptorHash {
+  std::size_t operator()(const Descriptor& d) const {
+    return std::hash<std::string>{}(d.name) * 31 + std::hash<int>{}(d.version);
+  }
+};
+
+using interned_descriptor =
+    interned_indirect_value<Descriptor, DescriptorHash>;
+}  // namespace
+
+TEST_CASE("interned_indirect_value is a single pointer",
+          "[interned_indirect_value.sizeof]") {
+  STATIC_REQUIRE(sizeof(interned_indirect_value<std::string>) ==
+                 sizeof(void*));
+}
+
+TEST_CASE("Equal values share one interned object",
+          "[interned_indirect_value.intern]") {
+  const std::size_t before = interned_descriptor::interned_count();
+  GIVEN("Two values constructed equal and one different") {
+    interned_descriptor a(Descriptor{"cold", 1});
+    interned_descriptor b(std::in_place, Descriptor{"cold", 1});
+    interned_descriptor c(Descriptor{"cold", 2});
+
+    THEN("The equal values share their pointee") {
+      REQUIRE(&*a == &*b);
+      REQUIRE(a == b);
+      REQUIRE(a.use_count() == 2);
+      REQUIRE(std::hash<interned_descriptor>{}(a) ==
+              std::hash<interned_descriptor>{}(b));
+    }
+    THEN("The different value has its own pointee") {
+      REQUIRE(&*a != &*c);
+      REQUIRE(a != c);
+      REQUIRE(c->version == 2);
+      REQUIRE(interned_descriptor::interned_count() == before + 2);
+    }
+  }
+  THEN("Values are removed when their last holder is destroyed") {
+    REQUIRE(interned_descriptor::interned_count() == before);
+  }
+}
+
+TEST_CASE("Copies share the interned object",
+          "[interned_indirect_value.copy]") {
+  auto a = make_interned_indirect_value<std::string>("shared");
+  GIVEN("A copy and a moved-to value") {
+    auto copy = a;
+    auto moved = std::move(copy);
+    THEN("Copies bump the count and moves transfer it") {
+      REQUIRE(&*moved == &*a);
+      REQUIRE(!copy);
+      REQUIRE(a.use_count() == 2);
+    }
+  }
+  GIVEN("Copy and move assignment") {
+    interned_indirect_value<std::string> b;
+    b = a;
+    REQUIRE(a.use_count() == 2);
+    b = interned_indirect_value<std::string>(std::string("other"));
+    REQUIRE(a.use_count() == 1);
+    REQUIRE(*b == "other");
+    b = a;
+    const auto& self = b;
+    b = self;
+    REQUIRE(a.use_count() == 2);
+  }
+}
+
+TEST_CASE("Modification copies on write",
+          "[interned_indirect_value.modify]") {
+  auto a = make_interned_indirect_value<std::string>("value");
+  auto b = a;
+  GIVEN("One holder modifying its value") {
+    b.modify([](std::string& s) { s += "!"; });
+    THEN("Only that holder sees the change") {
+      REQUIRE(*a == "value");
+      REQUIRE(*b == "value!");
+      REQUIRE(a.use_count() == 1);
+    }
+    THEN("Modifying it back shares the original again") {
+      b.modify([](std::string& s) { s.pop_back(); });
+      REQUIRE(&*a == &*b);
+    }
+  }
+  GIVEN("A value replaced by emplace") {
+    b.emplace(3, 'x');
+    REQUIRE(*b == "xxx");
+    REQUIRE(*a == "value");
+  }
+}
+
+TEST_CASE("Empty interned_indirect_values",
+          "[interned_indirect_value.empty]") {
+  interned_indirect_value<std::string> empty;
+  REQUIRE(!empty.has_value());
+  REQUIRE(empty.use_count() == 0);
+  REQUIRE(empty == interned_indirect_value<std::string>());
+  REQUIRE(interned_indirect_value<std::string>(
+              indirect_value<std::string>()) == empty);
+#ifndef ISOCPP_P1950_NO_EXCEPTIONS
+  REQUIRE_THROWS_AS(empty.value(), isocpp_p1950::bad_indirect_value_access);
+#endif
+}
+
+TEST_CASE("Interning an indirect_value",
+          "[interned_indirect_value.from_indirect_value]") {
+  const auto iv = make_indirect_value<std::string>("from indirect_value");
+  interned_indirect_value<std::string> a(iv);
+  interned_indirect_value<std::string> b(iv);
+  REQUIRE(a.value() == *iv);
+  REQUIRE(&*a != &*iv);
+  REQUIRE(&*a == &*b);
+}
+
+TEST_CASE("Interning from several threads",
+          "[interned_indirect_value.threads]") {
+  const std::size_t before = interned_indirect_value<int>::interned_count();
+  constexpr int distinct = 64;
+  std::vector<std::vector<interned_indirect_value<int>>> held(4);
+  {
+    std::vector<std::thread> threads;
+    for (auto& values : held) {
+      threads.emplace_back([&values] {
+        for (int round = 0; round != 50; ++round) {
+          std::vector<interned_indirect_value<int>> temporary;
+          for (int i = 0; i != distinct; ++i) {
+            temporary.emplace_back(std::in_place, i);
+            temporary.push_back(temporary.back());
+          }
+          if (round == 0) values = temporary;
+        }
+      });
+    }
+    for (auto& t : threads) t.join();
+  }
+  REQUIRE(interned_indirect_value<int>::interned_count() ==
+          before + distinct);
+  std::unordered_set<const int*> addresses;
+  for (const auto& values : held) {
+    for (const auto& v : values) addresses.insert(&*v);
+  }
+  REQUIRE(addresses.size() == distinct);
+  held.clear();
+  REQUIRE(interned_indirect_value<int>::interned_count() == before);
+}
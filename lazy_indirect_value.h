@@ -0,0 +1,136 @@
+/* Copyright (c) 2019 The Indirect Value Authors. All Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+==============================================================================*/
+
+#ifndef ISOCPP_P1950_LAZY_INDIRECT_VALUE_H
+#define ISOCPP_P1950_LAZY_INDIRECT_VALUE_H
+
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "indirect_value.h"
+
+namespace isocpp_p1950 {
+
+template <class T>
+struct default_factory {
+  constexpr T operator()() const { return T(); }
+};
+
+namespace detail {
+
+template <class T, class... Args>
+struct tuple_factory {
+  std::tuple<Args...> args;
+  constexpr T operator()() const { return std::make_from_tuple<T>(args); }
+};
+
+}  // namespace detail
+
+// A value-semantic owner of a T that is only allocated on first access.
+//
+// Until the pointee is needed only the factory (the construction recipe) is
+// stored; copying an unmaterialised lazy_indirect_value copies the factory and
+// allocates nothing. Dereferencing, including through a const access path,
+// materialises the pointee by allocating `new T(factory())`. Materialisation
+// through a const object is not synchronised: concurrent first accesses must
+// be externally serialised.
+template <class T, class F = default_factory<T>>
+class ISOCPP_P1950_EMPTY_BASES lazy_indirect_value
+    : private indirect_value_copy_base<F> {
+  using factory_base = indirect_value_copy_base<F>;
+
+  mutable indirect_value<T> value_;
+
+ public:
+  using value_type = T;
+  using factory_type = F;
+
+  constexpr lazy_indirect_value() = default;
+
+  constexpr explicit lazy_indirect_value(F f) : factory_base(std::move(f)) {}
+
+  // Adopts an already materialised value, keeping `f` to recreate it after
+  // reset().
+  constexpr explicit lazy_indirect_value(indirect_value<T> v, F f = F())
+      : factory_base(std::move(f)), value_(std::move(v)) {}
+
+  constexpr T* operator->() { return materialize(); }
+
+  constexpr const T* operator->() const { return materialize(); }
+
+  constexpr T& operator*() & { return *materialize(); }
+
+  constexpr const T& operator*() const& { return *materialize(); }
+
+  constexpr T&& operator*() && { return std::move(*materialize()); }
+
+  constexpr const T&& operator*() const&& {
+    return std::move(*materialize());
+  }
+
+  constexpr bool materialized() const noexcept { return value_.has_value(); }
+
+  // Destroys the pointee, if any. The next access re-runs the factory.
+  constexpr void reset() noexcept { value_ = indirect_value<T>(); }
+
+  constexpr factory_type& get_factory() noexcept { return factory_base::get(); }
+
+  constexpr const factory_type& get_factory() const noexcept {
+    return factory_base::get();
+  }
+
+  constexpr void swap(lazy_indirect_value& rhs) noexcept(
+      std::is_nothrow_swappable_v<F>) {
+    using std::swap;
+    swap(get_factory(), rhs.get_factory());
+    swap(value_, rhs.value_);
+  }
+
+  template <class TF = F>
+  friend constexpr std::enable_if_t<std::is_swappable_v<TF>> swap(
+      lazy_indirect_value& lhs,
+      lazy_indirect_value& rhs) noexcept(noexcept(lhs.swap(rhs))) {
+    lhs.swap(rhs);
+  }
+
+ private:
+  constexpr T* materialize() const {
+    if (!value_) {
+      // T is constructed directly from the factory's result, without a move.
+      value_ = indirect_value<T>(
+          detail::check_allocation(ISOCPP_P1950_NEW T(get_factory()())));
+    }
+    return value_.operator->();
+  }
+};
+
+// Creates a lazy_indirect_value whose recipe is `T(ts...)`. The arguments are
+// decay-copied and kept until the value is first accessed.
+template <class T, class... Ts>
+constexpr auto make_lazy_indirect_value(Ts&&... ts) {
+  using factory = detail::tuple_factory<T, std::decay_t<Ts>...>;
+  return lazy_indirect_value<T, factory>(
+      factory{std::tuple<std::decay_t<Ts>...>(std::forward<Ts>(ts)...)});
+}
+
+}  // namespace isocpp_p1950
+
+#endif  // ISOCPP_P1950_LAZY_INDIRECT_VALUE_H
@@ -0,0 +1,144 @@
+/* Copyright (c) 2019 The Indirect Value Authors. All Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+==============================================================================*/
+
+#include "lazy_indirect_value.h"
+
+#include <string>
+#include <utility>
+
+#include "catch2/catch_test_macros.hpp"
+
+using isocpp_p1950::indirect_value;
+using isocpp_p1950::lazy_indirect_value;
+using isocpp_p1950::make_indirect_value;
+using isocpp_p1950::make_lazy_indirect_value;
+
+namespace {
+struct ColdData {
+  std::string name;
+  int size = 0;
+
+  ColdData() { ++constructed; }
+  ColdData(std::string n, int s) : name(std::move(n)), size(s) {
+    ++constructed;
+  }
+  ColdData(const ColdData& c) : name(c.name), size(c.size) { ++constructed; }
+
+  inline static int constructed = 0;
+};
+}  // namespace
+
+TEST_CASE("lazy_indirect_value uses the minimum space requirements",
+          "[lazy_indirect_value.sizeof]") {
+  STATIC_REQUIRE(sizeof(lazy_indirect_value<int>) == sizeof(int*));
+}
+
+TEST_CASE("lazy_indirect_value allocates on first access",
+          "[lazy_indirect_value.materialize]") {
+  ColdData::constructed = 0;
+  GIVEN("A default constructed lazy_indirect_value") {
+    lazy_indirect_value<ColdData> lazy;
+    THEN("Nothing is constructed until the value is accessed") {
+      REQUIRE(!lazy.materialized());
+      REQUIRE(ColdData::constructed == 0);
+      REQUIRE(lazy->size == 0);
+      REQUIRE(lazy.materialized());
+      REQUIRE(ColdData::constructed == 1);
+    }
+    THEN("Access through a const reference materializes the value") {
+      const auto& c = lazy;
+      REQUIRE((*c).name.empty());
+      REQUIRE(c.materialized());
+    }
+    THEN("Repeated access reuses the same pointee") {
+      ColdData* first = &*lazy;
+      REQUIRE(&*lazy == first);
+      REQUIRE(ColdData::constructed == 1);
+    }
+  }
+  GIVEN("A lazy_indirect_value with a construction recipe") {
+    auto lazy = make_lazy_indirect_value<ColdData>("cold", 7);
+    THEN("The recipe is used on first access") {
+      REQUIRE(ColdData::constructed == 0);
+      REQUIRE(lazy->name == "cold");
+      REQUIRE(lazy->size == 7);
+    }
+    THEN("Reset returns to the unmaterialized state") {
+      lazy->size = 12;
+      lazy.reset();
+      REQUIRE(!lazy.materialized());
+      REQUIRE(lazy->size == 7);
+    }
+  }
+}
+
+TEST_CASE("Copying a lazy_indirect_value", "[lazy_indirect_value.copy]") {
+  ColdData::constructed = 0;
+  GIVEN("An unmaterialized lazy_indirect_value") {
+    auto lazy = make_lazy_indirect_value<ColdData>("cold", 7);
+    WHEN("It is copied") {
+      auto copy = lazy;
+      THEN("Only the recipe is copied") {
+        REQUIRE(!copy.materialized());
+        REQUIRE(ColdData::constructed == 0);
+        REQUIRE(copy->size == 7);
+      }
+    }
+  }
+  GIVEN("A materialized lazy_indirect_value") {
+    auto lazy = make_lazy_indirect_value<ColdData>("cold", 7);
+    lazy->size = 12;
+    WHEN("It is copied") {
+      auto copy = lazy;
+      THEN("The pointee is deep copied") {
+        REQUIRE(copy.materialized());
+        REQUIRE(copy->size == 12);
+        REQUIRE(&*copy != &*lazy);
+      }
+    }
+    WHEN("It is moved") {
+      const ColdData* address = &*lazy;
+      auto moved = std::move(lazy);
+      THEN("The pointee is transferred") {
+        REQUIRE(moved.materialized());
+        REQUIRE(&*moved == address);
+      }
+    }
+  }
+}
+
+TEST_CASE("lazy_indirect_value can adopt a materialized value",
+          "[lazy_indirect_value.adopt]") {
+  lazy_indirect_value<int> lazy(make_indirect_value<int>(5));
+  REQUIRE(lazy.materialized());
+  REQUIRE(*lazy == 5);
+  lazy.reset();
+  REQUIRE(*lazy == 0);
+}
+
+TEST_CASE("Swap overload for lazy_indirect_value",
+          "[lazy_indirect_value.swap]") {
+  lazy_indirect_value<int> a(make_indirect_value<int>(5));
+  lazy_indirect_value<int> b;
+  swap(a, b);
+  REQUIRE(!a.materialized());
+  REQUIRE(b.materialized());
+  REQUIRE(*b == 5);
+}
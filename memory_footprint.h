@@ -0,0 +1,248 @@
+/* Copyright (c) 2019 The Indirect Value Authors. All Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+==============================================================================*/
+
+#ifndef ISOCPP_P1950_MEMORY_FOOTPRINT_H
+#define ISOCPP_P1950_MEMORY_FOOTPRINT_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <typeindex>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+#if __has_include(<cxxabi.h>)
+#include <cxxabi.h>
+#define ISOCPP_P1950_HAS_CXXABI 1
+#endif
+
+#include "indirect_value.h"
+
+namespace isocpp_p1950 {
+
+class memory_footprint_report;
+
+// Specialise footprint_traits<T> with a static member function
+//
+//   static void owned_memory(const T&, memory_footprint_report&);
+//
+// to describe the memory owned by a type that cannot be given an overload of
+// owned_memory found by argument-dependent lookup, such as a standard library
+// type. memory_footprint_std.h provides specialisations for the standard
+// containers.
+template <class T, class = void>
+struct footprint_traits {};
+
+namespace detail {
+
+template <class T, class = void>
+struct has_footprint_traits : std::false_type {};
+
+template <class T>
+struct has_footprint_traits<
+    T, std::void_t<decltype(footprint_traits<T>::owned_memory(
+           std::declval<const T&>(),
+           std::declval<memory_footprint_report&>()))>> : std::true_type {};
+
+// Poison pill so that unqualified lookup inside this namespace only finds
+// owned_memory overloads through argument-dependent lookup.
+void owned_memory() = delete;
+
+template <class T, class = void>
+struct has_adl_owned_memory : std::false_type {};
+
+template <class T>
+struct has_adl_owned_memory<
+    T, std::void_t<decltype(owned_memory(
+           std::declval<const T&>(),
+           std::declval<memory_footprint_report&>()))>> : std::true_type {};
+
+inline std::string demangle(const char* name) {
+#ifdef ISOCPP_P1950_HAS_CXXABI
+  int status = 0;
+  std::unique_ptr<char, void (*)(void*)> demangled(
+      abi::__cxa_demangle(name, nullptr, nullptr, &status), std::free);
+  if (status == 0 && demangled) return demangled.get();
+#endif
+  return name;
+}
+
+}  // namespace detail
+
+// Estimates the bytes a general-purpose heap consumes for a request of
+// `bytes` with the given alignment. The model follows common malloc
+// implementations: one word of header, rounding to two words and a minimum
+// chunk of four words. Over-aligned requests pay for the alignment padding.
+inline std::size_t default_allocation_model(std::size_t bytes,
+                                            std::size_t alignment) noexcept {
+  constexpr std::size_t word = sizeof(void*);
+  constexpr std::size_t granule = 2 * word;
+  std::size_t chunk = (bytes + word + granule - 1) / granule * granule;
+  chunk = std::max(chunk, 4 * word);
+  if (alignment > granule) chunk += alignment;
+  return chunk;
+}
+
+// Allocations attributed to one type by memory_footprint.
+struct footprint_entry {
+  std::string type_name;
+  // The number of heap allocations.
+  std::size_t allocations = 0;
+  // The bytes requested by those allocations.
+  std::size_t bytes = 0;
+  // The estimated bookkeeping and rounding overhead of the allocator.
+  std::size_t overhead = 0;
+
+  std::size_t total() const noexcept { return bytes + overhead; }
+};
+
+// The heap memory owned by an object graph, attributed to the type that was
+// allocated.
+//
+// A report is filled in by walking the graph: each owner records its own
+// allocations with add_allocation and then recurses into the objects it owns
+// with add_owned. The memory of the root object itself is not included.
+class memory_footprint_report {
+ public:
+  using allocation_model = std::size_t (*)(std::size_t bytes,
+                                           std::size_t alignment);
+
+  explicit memory_footprint_report(
+      allocation_model model = default_allocation_model) noexcept
+      : model_(model) {}
+
+  // Records one heap allocation of `bytes` holding objects of type T.
+  template <class T>
+  void add_allocation(std::size_t bytes,
+                      std::size_t alignment = alignof(T)) {
+    entry& e = entries_[typeid(T)];
+    ++e.allocations;
+    e.bytes += bytes;
+    e.overhead += model_(bytes, alignment) - bytes;
+  }
+
+  // Records the memory owned by `t`, using footprint_traits<T> if it has been
+  // specialised and otherwise an owned_memory(const T&, report&) overload
+  // found by argument-dependent lookup. Types with neither own no memory.
+  template <class T>
+  void add_owned(const T& t) {
+    if constexpr (detail::has_footprint_traits<T>::value) {
+      footprint_traits<T>::owned_memory(t, *this);
+    } else if constexpr (detail::has_adl_owned_memory<T>::value) {
+      using detail::owned_memory;
+      owned_memory(t, *this);
+    }
+  }
+
+  std::size_t allocation_count() const noexcept {
+    return sum(&entry::allocations);
+  }
+
+  std::size_t requested_bytes() const noexcept { return sum(&entry::bytes); }
+
+  std::size_t overhead_bytes() const noexcept { return sum(&entry::overhead); }
+
+  std::size_t total_bytes() const noexcept {
+    return requested_bytes() + overhead_bytes();
+  }
+
+  // The per-type totals, largest first.
+  std::vector<footprint_entry> breakdown() const {
+    std::vector<footprint_entry> result;
+    result.reserve(entries_.size());
+    for (const auto& [type, e] : entries_) {
+      result.push_back(footprint_entry{detail::demangle(type.name()),
+                                       e.allocations, e.bytes, e.overhead});
+    }
+    std::sort(result.begin(), result.end(),
+              [](const footprint_entry& a, const footprint_entry& b) {
+                return a.total() != b.total() ? a.total() > b.total()
+                                              : a.type_name < b.type_name;
+              });
+    return result;
+  }
+
+  // The totals for allocations of type T.
+  template <class T>
+  footprint_entry entry_for() const {
+    footprint_entry result{detail::demangle(typeid(T).name())};
+    if (auto it = entries_.find(typeid(T)); it != entries_.end()) {
+      result.allocations = it->second.allocations;
+      result.bytes = it->second.bytes;
+      result.overhead = it->second.overhead;
+    }
+    return result;
+  }
+
+ private:
+  struct entry {
+    std::size_t allocations = 0;
+    std::size_t bytes = 0;
+    std::size_t overhead = 0;
+  };
+
+  std::size_t sum(std::size_t entry::*field) const noexcept {
+    std::size_t total = 0;
+    for (const auto& kv : entries_) total += kv.second.*field;
+    return total;
+  }
+
+  allocation_model model_;
+  std::map<std::type_index, entry> entries_;
+};
+
+// An engaged indirect_value owns one allocation holding a T, and whatever
+// that T owns. The estimate assumes the copier allocates each value
+// separately from a general-purpose heap.
+template <class T, class C, class D>
+void owned_memory(const indirect_value<T, C, D>& v,
+                  memory_footprint_report& report) {
+  if (!v) return;
+  report.add_allocation<T>(sizeof(T));
+  report.add_owned(*v);
+}
+
+template <class T, class C, class D>
+void owned_memory(const indirect_value<T[], C, D>& v,
+                  memory_footprint_report& report) {
+  if (!v) return;
+  report.add_allocation<T>(v.size() * sizeof(T));
+  for (const T& t : v) report.add_owned(t);
+}
+
+// Walks the object graph reachable from `t` and reports the heap memory it
+// owns, broken down by allocated type.
+template <class T>
+memory_footprint_report memory_footprint(
+    const T& t, memory_footprint_report::allocation_model model =
+                    default_allocation_model) {
+  memory_footprint_report report(model);
+  report.add_owned(t);
+  return report;
+}
+
+}  // namespace isocpp_p1950
+
+#endif  // ISOCPP_P1950_MEMORY_FOOTPRINT_H
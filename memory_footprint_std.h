@@ -0,0 +1,177 @@
+/* Copyright (c) 2019 The Indirect Value Authors. All Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+==============================================================================*/
+
+#ifndef ISOCPP_P1950_MEMORY_FOOTPRINT_STD_H
+#define ISOCPP_P1950_MEMORY_FOOTPRINT_STD_H
+
+// Opt-in footprint_traits for standard library types. Include this header
+// wherever memory_footprint is used on graphs containing them.
+//
+// Node sizes are estimates modelled on common implementations. Container
+// storage is attributed to the container type, so that the breakdown shows
+// which container is responsible for it.
+
+#include <climits>
+#include <type_traits>
+#include <cstddef>
+#include <list>
+#include <map>
+#include <optional>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "memory_footprint.h"
+
+namespace isocpp_p1950 {
+
+namespace detail {
+
+// Red-black tree nodes hold three links and a colour.
+inline constexpr std::size_t tree_node_links = 4 * sizeof(void*);
+
+// Hash nodes hold a link and, often, the cached hash.
+inline constexpr std::size_t hash_node_links = 2 * sizeof(void*);
+
+// Doubly linked list nodes hold two links.
+inline constexpr std::size_t list_node_links = 2 * sizeof(void*);
+
+template <class Container, std::size_t Links>
+struct node_container_footprint {
+  static void owned_memory(const Container& c,
+                           memory_footprint_report& report) {
+    using value_type = typename Container::value_type;
+    for (const value_type& v : c) {
+      report.add_allocation<Container>(sizeof(value_type) + Links,
+                                       alignof(value_type));
+      report.add_owned(v);
+    }
+  }
+};
+
+template <class Container>
+struct hash_container_footprint {
+  static void owned_memory(const Container& c,
+                           memory_footprint_report& report) {
+    report.add_allocation<Container>(c.bucket_count() * sizeof(void*),
+                                     alignof(void*));
+    node_container_footprint<Container, hash_node_links>::owned_memory(
+        c, report);
+  }
+};
+
+}  // namespace detail
+
+template <class T1, class T2>
+struct footprint_traits<std::pair<T1, T2>> {
+  static void owned_memory(const std::pair<T1, T2>& p,
+                           memory_footprint_report& report) {
+    report.add_owned(p.first);
+    report.add_owned(p.second);
+  }
+};
+
+template <class T>
+struct footprint_traits<std::optional<T>> {
+  static void owned_memory(const std::optional<T>& o,
+                           memory_footprint_report& report) {
+    if (o) report.add_owned(*o);
+  }
+};
+
+template <class CharT, class Traits, class A>
+struct footprint_traits<std::basic_string<CharT, Traits, A>> {
+  using string = std::basic_string<CharT, Traits, A>;
+
+  static void owned_memory(const string& s, memory_footprint_report& report) {
+    // Short strings are stored inside the string object itself.
+    const auto* first = reinterpret_cast<const unsigned char*>(&s);
+    const auto* data = reinterpret_cast<const unsigned char*>(s.data());
+    if (data >= first && data < first + sizeof(string)) return;
+    report.add_allocation<string>((s.capacity() + 1) * sizeof(CharT),
+                                  alignof(CharT));
+  }
+};
+
+template <class T, class A>
+struct footprint_traits<std::vector<T, A>> {
+  static void owned_memory(const std::vector<T, A>& v,
+                           memory_footprint_report& report) {
+    if (v.capacity() == 0) return;
+    if constexpr (std::is_same_v<T, bool>) {
+      report.add_allocation<std::vector<T, A>>(
+          (v.capacity() + CHAR_BIT - 1) / CHAR_BIT, alignof(std::size_t));
+    } else {
+      report.add_allocation<std::vector<T, A>>(v.capacity() * sizeof(T),
+                                               alignof(T));
+      for (const T& t : v) report.add_owned(t);
+    }
+  }
+};
+
+template <class T, class A>
+struct footprint_traits<std::list<T, A>>
+    : detail::node_container_footprint<std::list<T, A>,
+                                       detail::list_node_links> {};
+
+template <class K, class V, class Cmp, class A>
+struct footprint_traits<std::map<K, V, Cmp, A>>
+    : detail::node_container_footprint<std::map<K, V, Cmp, A>,
+                                       detail::tree_node_links> {};
+
+template <class K, class V, class Cmp, class A>
+struct footprint_traits<std::multimap<K, V, Cmp, A>>
+    : detail::node_container_footprint<std::multimap<K, V, Cmp, A>,
+                                       detail::tree_node_links> {};
+
+template <class K, class Cmp, class A>
+struct footprint_traits<std::set<K, Cmp, A>>
+    : detail::node_container_footprint<std::set<K, Cmp, A>,
+                                       detail::tree_node_links> {};
+
+template <class K, class Cmp, class A>
+struct footprint_traits<std::multiset<K, Cmp, A>>
+    : detail::node_container_footprint<std::multiset<K, Cmp, A>,
+                                       detail::tree_node_links> {};
+
+template <class K, class V, class H, class E, class A>
+struct footprint_traits<std::unordered_map<K, V, H, E, A>>
+    : detail::hash_container_footprint<std::unordered_map<K, V, H, E, A>> {};
+
+template <class K, class V, class H, class E, class A>
+struct footprint_traits<std::unordered_multimap<K, V, H, E, A>>
+    : detail::hash_container_footprint<
+          std::unordered_multimap<K, V, H, E, A>> {};
+
+template <class K, class H, class E, class A>
+struct footprint_traits<std::unordered_set<K, H, E, A>>
+    : detail::hash_container_footprint<std::unordered_set<K, H, E, A>> {};
+
+template <class K, class H, class E, class A>
+struct footprint_traits<std::unordered_multiset<K, H, E, A>>
+    : detail::hash_container_footprint<std::unordered_multiset<K, H, E, A>> {
+};
+
+}  // namespace isocpp_p1950
+
+#endif  // ISOCPP_P1950_MEMORY_FOOTPRINT_STD_H
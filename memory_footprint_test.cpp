@@ -0,0 +1,167 @@
+/* Copyright (c) 2019 The Indirect Value Authors. All Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+==============================================================================*/
+
+#include "memory_footprint.h"
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "catch2/catch_test_macros.hpp"
+#include "memory_footprint_std.h"
+
+using isocpp_p1950::default_allocation_model;
+using isocpp_p1950::indirect_value;
+using isocpp_p1950::make_indirect_value;
+using isocpp_p1950::memory_footprint;
+using isocpp_p1950::memory_footprint_report;
+
+namespace {
+struct Leaf {
+  double values[4] = {};
+};
+
+struct Node {
+  indirect_value<Leaf> left;
+  indirect_value<Leaf> right;
+};
+
+// Aggregates are not visited automatically; an owner lists its members.
+void owned_memory(const Node& n, memory_footprint_report& report) {
+  report.add_owned(n.left);
+  report.add_owned(n.right);
+}
+
+// Owns a buffer that is not an indirect_value and describes it with an
+// owned_memory overload found by argument-dependent lookup.
+struct Buffer {
+  std::size_t size = 0;
+  std::unique_ptr<char[]> data;
+};
+
+void owned_memory(const Buffer& b, memory_footprint_report& report) {
+  if (b.data) report.add_allocation<char>(b.size);
+}
+
+struct Document {
+  indirect_value<Buffer> body;
+  std::vector<indirect_value<Node>> nodes;
+  std::map<int, std::string> index;
+};
+
+void owned_memory(const Document& d, memory_footprint_report& report) {
+  report.add_owned(d.body);
+  report.add_owned(d.nodes);
+  report.add_owned(d.index);
+}
+
+// Counts requested bytes only.
+std::size_t exact_model(std::size_t bytes, std::size_t) { return bytes; }
+}  // namespace
+
+TEST_CASE("Footprint of a single indirect_value",
+          "[memory_footprint.indirect_value]") {
+  GIVEN("An empty indirect_value") {
+    indirect_value<Leaf> v;
+    THEN("It owns no memory") {
+      const auto report = memory_footprint(v);
+      REQUIRE(report.allocation_count() == 0);
+      REQUIRE(report.total_bytes() == 0);
+      REQUIRE(report.breakdown().empty());
+    }
+  }
+  GIVEN("An engaged indirect_value") {
+    auto v = make_indirect_value<Leaf>();
+    THEN("It owns one allocation of sizeof(T) plus allocator overhead") {
+      const auto report = memory_footprint(v);
+      REQUIRE(report.allocation_count() == 1);
+      REQUIRE(report.requested_bytes() == sizeof(Leaf));
+      REQUIRE(report.total_bytes() ==
+              default_allocation_model(sizeof(Leaf), alignof(Leaf)));
+      REQUIRE(report.overhead_bytes() > 0);
+    }
+  }
+  GIVEN("An indirect_value holding an array") {
+    auto v = make_indirect_value<Leaf[]>(3);
+    THEN("It owns one allocation for all elements") {
+      const auto report = memory_footprint(v, exact_model);
+      REQUIRE(report.allocation_count() == 1);
+      REQUIRE(report.total_bytes() == 3 * sizeof(Leaf));
+    }
+  }
+}
+
+TEST_CASE("Footprint of nested indirect_values is recursive",
+          "[memory_footprint.recursive]") {
+  Node node;
+  node.left = make_indirect_value<Leaf>();
+  auto outer = make_indirect_value<Node>(std::move(node));
+
+  const auto report = memory_footprint(outer, exact_model);
+  REQUIRE(report.allocation_count() == 2);
+  REQUIRE(report.total_bytes() == sizeof(Node) + sizeof(Leaf));
+  REQUIRE(report.entry_for<Node>().allocations == 1);
+  REQUIRE(report.entry_for<Leaf>().bytes == sizeof(Leaf));
+}
+
+TEST_CASE("Footprint of user-declared and container memory",
+          "[memory_footprint.breakdown]") {
+  Document doc;
+  doc.body = make_indirect_value<Buffer>(
+      Buffer{1000, std::make_unique<char[]>(1000)});
+  doc.nodes.reserve(8);
+  for (int i = 0; i < 4; ++i) {
+    doc.nodes.push_back(make_indirect_value<Node>());
+    doc.nodes.back()->right = make_indirect_value<Leaf>();
+  }
+  doc.index[1] = "short";
+  doc.index[2] = std::string(200, 'x');
+
+  const auto report = memory_footprint(doc, exact_model);
+
+  THEN("User-declared memory is included") {
+    REQUIRE(report.entry_for<char>().bytes == 1000);
+    REQUIRE(report.entry_for<Buffer>().allocations == 1);
+  }
+  THEN("Vector storage and its elements are included") {
+    using nodes_type = std::vector<indirect_value<Node>>;
+    REQUIRE(report.entry_for<nodes_type>().bytes ==
+            8 * sizeof(indirect_value<Node>));
+    REQUIRE(report.entry_for<Node>().allocations == 4);
+    REQUIRE(report.entry_for<Leaf>().allocations == 4);
+  }
+  THEN("Map nodes and long strings are included") {
+    using index_type = std::map<int, std::string>;
+    REQUIRE(report.entry_for<index_type>().allocations == 2);
+    REQUIRE(report.entry_for<std::string>().allocations == 1);
+    REQUIRE(report.entry_for<std::string>().bytes >= 201);
+  }
+  THEN("The breakdown is ordered largest first and sums to the total") {
+    const auto breakdown = report.breakdown();
+    REQUIRE(breakdown.front().type_name == "char");
+    std::size_t total = 0;
+    for (std::size_t i = 0; i != breakdown.size(); ++i) {
+      total += breakdown[i].total();
+      if (i) REQUIRE(breakdown[i - 1].total() >= breakdown[i].total());
+    }
+    REQUIRE(total == report.total_bytes());
+  }
+}
@@ -0,0 +1,376 @@
+/* Copyright (c) 2019 The Indirect Value Authors. All Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+==============================================================================*/
+
+#ifndef ISOCPP_P1950_NONNULL_INDIRECT_VALUE_H
+#define ISOCPP_P1950_NONNULL_INDIRECT_VALUE_H
+
+#include <cstddef>
+#include <functional>
+#include <type_traits>
+#include <utility>
+
+#include "indirect_value.h"
+
+namespace isocpp_p1950 {
+
+// An indirect_value that always owns a T.
+//
+// There is no empty state, so dereferencing, value(), the relational
+// operators and std::hash do not test for null. The move constructor takes
+// the pointee and leaves the source valueless; only assignment, destruction,
+// valueless_after_move() and operator bool may be used on a moved-from
+// nonnull_indirect_value. Move assignment swaps the pointees, which never
+// allocates and leaves the source holding the target's previous value.
+//
+// Copiers and deleters are customised as for indirect_value, and const is
+// propagated to the pointee in the same way.
+template <class T, class C = default_copy<T>,
+          class D = typename copier_traits<C>::deleter_type>
+class ISOCPP_P1950_EMPTY_BASES nonnull_indirect_value
+    : private indirect_value_copy_base<C>,
+      private indirect_value_delete_base<D> {
+  using copy_base = indirect_value_copy_base<C>;
+  using delete_base = indirect_value_delete_base<D>;
+
+  T* ptr_;
+
+ public:
+  using value_type = T;
+  using copier_type = C;
+  using deleter_type = D;
+
+  template <class TT = T,
+            class = std::enable_if_t<std::is_default_constructible_v<TT>>>
+  constexpr nonnull_indirect_value() : ptr_(detail::new_object<T>()) {}
+
+  template <class... Ts>
+  constexpr explicit nonnull_indirect_value(std::in_place_t, Ts&&... ts)
+      : ptr_(detail::new_object<T>(std::forward<Ts>(ts)...)) {}
+
+  // Takes ownership of `u`, which must not be null. A null pointer is
+  // reported as by indirect_value::value() on an empty value.
+  template <class U, class = std::enable_if_t<std::is_same_v<T, U> &&
+      std::is_default_constructible_v<C> &&
+      not std::is_pointer_v<C> &&
+      std::is_default_constructible_v<D> &&
+      not std::is_pointer_v<D>>>
+  constexpr explicit nonnull_indirect_value(U* u)
+      : copy_base(C{}), delete_base(D{}), ptr_(checked(u)) {}
+
+  template <class U, class = std::enable_if_t<std::is_same_v<T, U> &&
+      std::is_default_constructible_v<D> &&
+      not std::is_pointer_v<D>>>
+  constexpr explicit nonnull_indirect_value(U* u, C c)
+      : copy_base(std::move(c)), delete_base(D{}), ptr_(checked(u)) {}
+
+  template <class U, class = std::enable_if_t<std::is_same_v<T, U>>>
+  constexpr explicit nonnull_indirect_value(U* u, C c, D d)
+      : copy_base(std::move(c)),
+        delete_base(std::move(d)),
+        ptr_(checked(u)) {}
+
+  constexpr nonnull_indirect_value(const nonnull_indirect_value& i)
+      : copy_base(i.get_c()), delete_base(i.get_d()), ptr_(i.get_c()(*i)) {}
+
+  constexpr nonnull_indirect_value(nonnull_indirect_value&& i) noexcept
+      : copy_base(std::move(i)),
+        delete_base(std::move(i)),
+        ptr_(std::exchange(i.ptr_, nullptr)) {}
+
+  constexpr nonnull_indirect_value& operator=(
+      const nonnull_indirect_value& i) {
+    // When copying T throws, *this will remain unchanged.
+    if (this != &i) {
+      nonnull_indirect_value copy(i);
+      swap(copy);
+    }
+    return *this;
+  }
+
+  // Exchanges the pointees, so that both objects remain engaged.
+  constexpr nonnull_indirect_value& operator=(
+      nonnull_indirect_value&& i) noexcept(noexcept(i.swap(i))) {
+    swap(i);
+    return *this;
+  }
+
+  ISOCPP_P1950_CONSTEXPR_CXX20 ~nonnull_indirect_value() {
+    if (ptr_) get_d()(ptr_);
+  }
+
+  constexpr T* operator->() noexcept { return ptr_; }
+
+  constexpr const T* operator->() const noexcept { return ptr_; }
+
+  constexpr T& operator*() & noexcept { return *ptr_; }
+
+  constexpr const T& operator*() const& noexcept { return *ptr_; }
+
+  constexpr T&& operator*() && noexcept { return std::move(*ptr_); }
+
+  constexpr const T&& operator*() const&& noexcept {
+    return std::move(*ptr_);
+  }
+
+  constexpr T& value() & noexcept { return *ptr_; }
+
+  constexpr const T& value() const& noexcept { return *ptr_; }
+
+  constexpr T&& value() && noexcept { return std::move(*ptr_); }
+
+  constexpr const T&& value() const&& noexcept { return std::move(*ptr_); }
+
+  constexpr bool valueless_after_move() const noexcept {
+    return ptr_ == nullptr;
+  }
+
+  // True unless moved from, so that code written for indirect_value, such as
+  // its std::hash, can be used unchanged.
+  explicit constexpr operator bool() const noexcept { return ptr_ != nullptr; }
+
+  constexpr copier_type& get_copier() noexcept { return get_c(); }
+
+  constexpr const copier_type& get_copier() const noexcept { return get_c(); }
+
+  constexpr deleter_type& get_deleter() noexcept { return get_d(); }
+
+  constexpr const deleter_type& get_deleter() const noexcept { return get_d(); }
+
+  constexpr void swap(nonnull_indirect_value& rhs) noexcept(
+      std::is_nothrow_swappable_v<C>&& std::is_nothrow_swappable_v<D>) {
+    using std::swap;
+    swap(get_c(), rhs.get_c());
+    swap(get_d(), rhs.get_d());
+    swap(ptr_, rhs.ptr_);
+  }
+
+  template <class TC = C>
+  friend constexpr std::enable_if_t<std::is_swappable_v<TC> &&
+                                    std::is_swappable_v<D>>
+  swap(nonnull_indirect_value& lhs,
+       nonnull_indirect_value& rhs) noexcept(noexcept(lhs.swap(rhs))) {
+    lhs.swap(rhs);
+  }
+
+ private:
+  static constexpr T* checked(T* u) {
+    if (!u) detail::handle_bad_access();
+    return u;
+  }
+
+  constexpr C& get_c() noexcept { return copy_base::get(); }
+
+  constexpr const C& get_c() const noexcept { return copy_base::get(); }
+
+  constexpr D& get_d() noexcept { return delete_base::get(); }
+
+  constexpr const D& get_d() const noexcept { return delete_base::get(); }
+};
+
+template <class T, class... Ts>
+constexpr nonnull_indirect_value<T> make_nonnull_indirect_value(Ts&&... ts) {
+  return nonnull_indirect_value<T>(std::in_place, std::forward<Ts>(ts)...);
+}
+
+template <class>
+inline constexpr bool _is_nonnull_indirect_value_v = false;
+
+template <class T, class C, class D>
+inline constexpr bool
+    _is_nonnull_indirect_value_v<nonnull_indirect_value<T, C, D>> = true;
+
+// The relational operators are available exactly when they are for the
+// corresponding indirect_values, whichever overloads indirect_value.h
+// provides, and compare the pointees without testing for null.
+template <class T1, class C1, class D1, class T2, class C2, class D2>
+constexpr auto operator==(const nonnull_indirect_value<T1, C1, D1>& lhs,
+                          const nonnull_indirect_value<T2, C2, D2>& rhs)
+    -> _enable_if_comparable_with_equal<indirect_value<T1, C1, D1>,
+                                         indirect_value<T2, C2, D2>> {
+  return *lhs == *rhs;
+}
+
+template <class T1, class C1, class D1, class T2, class C2, class D2>
+constexpr auto operator!=(const nonnull_indirect_value<T1, C1, D1>& lhs,
+                          const nonnull_indirect_value<T2, C2, D2>& rhs)
+    -> _enable_if_comparable_with_not_equal<indirect_value<T1, C1, D1>,
+                                             indirect_value<T2, C2, D2>> {
+  return *lhs != *rhs;
+}
+
+template <class T1, class C1, class D1, class T2, class C2, class D2>
+constexpr auto operator<(const nonnull_indirect_value<T1, C1, D1>& lhs,
+                         const nonnull_indirect_value<T2, C2, D2>& rhs)
+    -> _enable_if_comparable_with_less<indirect_value<T1, C1, D1>,
+                                        indirect_value<T2, C2, D2>> {
+  return *lhs < *rhs;
+}
+
+template <class T1, class C1, class D1, class T2, class C2, class D2>
+constexpr auto operator>(const nonnull_indirect_value<T1, C1, D1>& lhs,
+                         const nonnull_indirect_value<T2, C2, D2>& rhs)
+    -> _enable_if_comparable_with_greater<indirect_value<T1, C1, D1>,
+                                           indirect_value<T2, C2, D2>> {
+  return *lhs > *rhs;
+}
+
+template <class T1, class C1, class D1, class T2, class C2, class D2>
+constexpr auto operator<=(const nonnull_indirect_value<T1, C1, D1>& lhs,
+                          const nonnull_indirect_value<T2, C2, D2>& rhs)
+    -> _enable_if_comparable_with_less_equal<indirect_value<T1, C1, D1>,
+                                              indirect_value<T2, C2, D2>> {
+  return *lhs <= *rhs;
+}
+
+template <class T1, class C1, class D1, class T2, class C2, class D2>
+constexpr auto operator>=(const nonnull_indirect_value<T1, C1, D1>& lhs,
+                          const nonnull_indirect_value<T2, C2, D2>& rhs)
+    -> _enable_if_comparable_with_greater_equal<indirect_value<T1, C1, D1>,
+                                                 indirect_value<T2, C2, D2>> {
+  return *lhs >= *rhs;
+}
+
+#if defined(__cpp_lib_three_way_comparison) && defined(__cpp_lib_concepts)
+template <class T1, class C1, class D1, class T2, class C2, class D2>
+constexpr auto operator<=>(const nonnull_indirect_value<T1, C1, D1>& lhs,
+                           const nonnull_indirect_value<T2, C2, D2>& rhs)
+    -> decltype(std::declval<const indirect_value<T1, C1, D1>&>() <=>
+                std::declval<const indirect_value<T2, C2, D2>&>()) {
+  return *lhs <=> *rhs;
+}
+#endif
+
+// Comparisons with T
+template <class T, class C, class D, class U,
+          class = std::enable_if_t<!_is_nonnull_indirect_value_v<U>>>
+constexpr auto operator==(const nonnull_indirect_value<T, C, D>& lhs,
+                          const U& rhs)
+    -> _enable_if_comparable_with_equal<indirect_value<T, C, D>, U> {
+  return *lhs == rhs;
+}
+
+template <class T, class C, class D, class U,
+          class = std::enable_if_t<!_is_nonnull_indirect_value_v<T>>>
+constexpr auto operator==(const T& lhs,
+                          const nonnull_indirect_value<U, C, D>& rhs)
+    -> _enable_if_comparable_with_equal<T, indirect_value<U, C, D>> {
+  return lhs == *rhs;
+}
+
+template <class T, class C, class D, class U,
+          class = std::enable_if_t<!_is_nonnull_indirect_value_v<U>>>
+constexpr auto operator!=(const nonnull_indirect_value<T, C, D>& lhs,
+                          const U& rhs)
+    -> _enable_if_comparable_with_not_equal<indirect_value<T, C, D>, U> {
+  return *lhs != rhs;
+}
+
+template <class T, class C, class D, class U,
+          class = std::enable_if_t<!_is_nonnull_indirect_value_v<T>>>
+constexpr auto operator!=(const T& lhs,
+                          const nonnull_indirect_value<U, C, D>& rhs)
+    -> _enable_if_comparable_with_not_equal<T, indirect_value<U, C, D>> {
+  return lhs != *rhs;
+}
+
+template <class T, class C, class D, class U,
+          class = std::enable_if_t<!_is_nonnull_indirect_value_v<U>>>
+constexpr auto operator<(const nonnull_indirect_value<T, C, D>& lhs,
+                         const U& rhs)
+    -> _enable_if_comparable_with_less<indirect_value<T, C, D>, U> {
+  return *lhs < rhs;
+}
+
+template <class T, class C, class D, class U,
+          class = std::enable_if_t<!_is_nonnull_indirect_value_v<T>>>
+constexpr auto operator<(const T& lhs,
+                         const nonnull_indirect_value<U, C, D>& rhs)
+    -> _enable_if_comparable_with_less<T, indirect_value<U, C, D>> {
+  return lhs < *rhs;
+}
+
+template <class T, class C, class D, class U,
+          class = std::enable_if_t<!_is_nonnull_indirect_value_v<U>>>
+constexpr auto operator>(const nonnull_indirect_value<T, C, D>& lhs,
+                         const U& rhs)
+    -> _enable_if_comparable_with_greater<indirect_value<T, C, D>, U> {
+  return *lhs > rhs;
+}
+
+template <class T, class C, class D, class U,
+          class = std::enable_if_t<!_is_nonnull_indirect_value_v<T>>>
+constexpr auto operator>(const T& lhs,
+                         const nonnull_indirect_value<U, C, D>& rhs)
+    -> _enable_if_comparable_with_greater<T, indirect_value<U, C, D>> {
+  return lhs > *rhs;
+}
+
+template <class T, class C, class D, class U,
+          class = std::enable_if_t<!_is_nonnull_indirect_value_v<U>>>
+constexpr auto operator<=(const nonnull_indirect_value<T, C, D>& lhs,
+                          const U& rhs)
+    -> _enable_if_comparable_with_less_equal<indirect_value<T, C, D>, U> {
+  return *lhs <= rhs;
+}
+
+template <class T, class C, class D, class U,
+          class = std::enable_if_t<!_is_nonnull_indirect_value_v<T>>>
+constexpr auto operator<=(const T& lhs,
+                          const nonnull_indirect_value<U, C, D>& rhs)
+    -> _enable_if_comparable_with_less_equal<T, indirect_value<U, C, D>> {
+  return lhs <= *rhs;
+}
+
+template <class T, class C, class D, class U,
+          class = std::enable_if_t<!_is_nonnull_indirect_value_v<U>>>
+constexpr auto operator>=(const nonnull_indirect_value<T, C, D>& lhs,
+                          const U& rhs)
+    -> _enable_if_comparable_with_greater_equal<indirect_value<T, C, D>, U> {
+  return *lhs >= rhs;
+}
+
+template <class T, class C, class D, class U,
+          class = std::enable_if_t<!_is_nonnull_indirect_value_v<T>>>
+constexpr auto operator>=(const T& lhs,
+                          const nonnull_indirect_value<U, C, D>& rhs)
+    -> _enable_if_comparable_with_greater_equal<T, indirect_value<U, C, D>> {
+  return lhs >= *rhs;
+}
+
+#if defined(__cpp_lib_three_way_comparison) && defined(__cpp_lib_concepts)
+template <class T, class C, class D, class U>
+requires(!_is_nonnull_indirect_value_v<U>) constexpr auto operator<=>(
+    const nonnull_indirect_value<T, C, D>& lhs, const U& rhs)
+    -> decltype(std::declval<const indirect_value<T, C, D>&>() <=> rhs) {
+  return *lhs <=> rhs;
+}
+#endif
+
+}  // namespace isocpp_p1950
+
+namespace std {
+template <class T, class C, class D>
+struct hash<::isocpp_p1950::nonnull_indirect_value<T, C, D>>
+    : ::isocpp_p1950::_conditionally_enabled_hash<
+          ::isocpp_p1950::nonnull_indirect_value<T, C, D>,
+          is_default_constructible_v<hash<T>>> {};
+}  // namespace std
+
+#endif  // ISOCPP_P1950_NONNULL_INDIRECT_VALUE_H
@@ -0,0 +1,178 @@
+/* Copyright (c) 2019 The Indirect Value Authors. All Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+==============================================================================*/
+
+#include "nonnull_indirect_value.h"
+
+#include <algorithm>
+#include <functional>
+#include <set>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "catch2/catch_test_macros.hpp"
+
+using isocpp_p1950::bad_indirect_value_access;
+using isocpp_p1950::make_nonnull_indirect_value;
+using isocpp_p1950::nonnull_indirect_value;
+
+TEST_CASE("nonnull_indirect_value uses the minimum space requirements",
+          "[nonnull_indirect_value.sizeof]") {
+  STATIC_REQUIRE(sizeof(nonnull_indirect_value<int>) == sizeof(int*));
+}
+
+TEST_CASE("nonnull_indirect_value propagates const",
+          "[nonnull_indirect_value.const]") {
+  using V = nonnull_indirect_value<int>;
+  STATIC_REQUIRE(std::is_same_v<decltype(*std::declval<V&>()), int&>);
+  STATIC_REQUIRE(
+      std::is_same_v<decltype(*std::declval<const V&>()), const int&>);
+  STATIC_REQUIRE(
+      std::is_same_v<decltype(std::declval<const V&>().operator->()),
+                     const int*>);
+  STATIC_REQUIRE(noexcept(std::declval<const V&>().value()));
+}
+
+TEST_CASE("nonnull_indirect_value is always engaged",
+          "[nonnull_indirect_value.construct]") {
+  GIVEN("A default constructed nonnull_indirect_value") {
+    nonnull_indirect_value<std::string> v;
+    THEN("It holds a value-initialised T") { REQUIRE(v->empty()); }
+  }
+  GIVEN("A nonnull_indirect_value constructed in place") {
+    auto v = make_nonnull_indirect_value<std::string>(3, 'x');
+    THEN("It holds the constructed value") { REQUIRE(*v == "xxx"); }
+  }
+  GIVEN("A nonnull_indirect_value adopting a pointer") {
+    nonnull_indirect_value<int> v(new int(4));
+    THEN("It owns the pointee") { REQUIRE(v.value() == 4); }
+  }
+#ifndef ISOCPP_P1950_NO_EXCEPTIONS
+  GIVEN("A null pointer") {
+    THEN("Adopting it is reported as a bad access") {
+      REQUIRE_THROWS_AS(nonnull_indirect_value<int>(static_cast<int*>(nullptr)),
+                        bad_indirect_value_access);
+    }
+  }
+#endif
+}
+
+TEST_CASE("Copying and moving a nonnull_indirect_value",
+          "[nonnull_indirect_value.copy]") {
+  auto a = make_nonnull_indirect_value<std::string>("a");
+  GIVEN("A copy") {
+    auto b = a;
+    THEN("The pointee is deep copied") {
+      REQUIRE(*b == "a");
+      REQUIRE(&*b != &*a);
+    }
+  }
+  GIVEN("A value constructed from an rvalue") {
+    const std::string* address = &*a;
+    auto b = std::move(a);
+    THEN("The pointee is taken and the source is valueless") {
+      REQUIRE(&*b == address);
+      REQUIRE(*b == "a");
+      REQUIRE(!b.valueless_after_move());
+      REQUIRE(a.valueless_after_move());
+      REQUIRE(!a);
+    }
+    AND_WHEN("The source is assigned to") {
+      a = make_nonnull_indirect_value<std::string>("c");
+      THEN("It holds a value again") {
+        REQUIRE(!a.valueless_after_move());
+        REQUIRE(*a == "c");
+      }
+    }
+  }
+  GIVEN("Copy assignment") {
+    auto b = make_nonnull_indirect_value<std::string>("b");
+    b = a;
+    THEN("The target holds a copy") {
+      REQUIRE(*b == "a");
+      REQUIRE(&*b != &*a);
+    }
+  }
+  GIVEN("Move assignment") {
+    auto b = make_nonnull_indirect_value<std::string>("b");
+    const std::string* a_address = &*a;
+    const std::string* b_address = &*b;
+    b = std::move(a);
+    THEN("The pointees are exchanged without copying") {
+      REQUIRE(&*b == a_address);
+      REQUIRE(&*a == b_address);
+      REQUIRE(*a == "b");
+    }
+  }
+  GIVEN("Swap") {
+    auto b = make_nonnull_indirect_value<std::string>("b");
+    swap(a, b);
+    THEN("The values are exchanged") {
+      REQUIRE(*a == "b");
+      REQUIRE(*b == "a");
+    }
+  }
+}
+
+TEST_CASE("Relational operators on nonnull_indirect_value",
+          "[nonnull_indirect_value.relops]") {
+  const auto one = make_nonnull_indirect_value<int>(1);
+  const auto two = make_nonnull_indirect_value<int>(2);
+  const auto also_one = make_nonnull_indirect_value<int>(1);
+
+  REQUIRE(one == also_one);
+  REQUIRE(one != two);
+  REQUIRE(one < two);
+  REQUIRE(two > one);
+  REQUIRE(one <= also_one);
+  REQUIRE(two >= one);
+
+  REQUIRE(one == 1);
+  REQUIRE(2 == two);
+  REQUIRE(one != 2);
+  REQUIRE(one < 2);
+  REQUIRE(0 < one);
+  REQUIRE(two > 1);
+  REQUIRE(one <= 1);
+  REQUIRE(two >= 2);
+}
+
+TEST_CASE("Sorting and searching nonnull_indirect_values",
+          "[nonnull_indirect_value.algorithms]") {
+  std::vector<nonnull_indirect_value<int>> values;
+  for (int i : {5, 3, 9, 1, 7}) values.emplace_back(std::in_place, i);
+  std::set<const int*> pointees;
+  for (const auto& v : values) pointees.insert(&*v);
+  std::sort(values.begin(), values.end());
+  REQUIRE(std::is_sorted(values.begin(), values.end()));
+  // Sorting moves the pointers; no pointee is copied.
+  for (const auto& v : values) REQUIRE(pointees.count(&*v) == 1);
+  REQUIRE(*values.front() == 1);
+  REQUIRE(std::binary_search(values.begin(), values.end(), 7));
+  REQUIRE(!std::binary_search(values.begin(), values.end(), 4));
+}
+
+TEST_CASE("Hash for nonnull_indirect_value",
+          "[nonnull_indirect_value.hash]") {
+  const auto v = make_nonnull_indirect_value<std::string>("key");
+  REQUIRE(std::hash<nonnull_indirect_value<std::string>>{}(v) ==
+          std::hash<std::string>{}("key"));
+}
@@ -0,0 +1,289 @@
+/* Copyright (c) 2019 The Indirect Value Authors. All Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+==============================================================================*/
+
+#ifndef ISOCPP_P1950_NUMA_LOCAL_COPY_H
+#define ISOCPP_P1950_NUMA_LOCAL_COPY_H
+
+#include <atomic>
+#include <cstddef>
+#include <fstream>
+#include <mutex>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "indirect_value.h"
+
+namespace isocpp_p1950 {
+
+namespace detail::numa {
+
+#if defined(__linux__) && defined(SYS_mbind) && defined(SYS_getcpu)
+inline constexpr bool supported = true;
+#else
+inline constexpr bool supported = false;
+#endif
+
+// Number of NUMA nodes the kernel may bring online, read once from sysfs.
+inline int node_count() noexcept {
+  static const int count = []() noexcept {
+    if constexpr (!supported) return 1;
+    std::ifstream possible("/sys/devices/system/node/possible");
+    std::string ranges;
+    if (!(possible >> ranges)) return 1;
+    // The file lists ranges such as "0" or "0-1,4"; the node count is one more
+    // than the highest node number.
+    int highest = 0;
+    int current = 0;
+    bool in_number = false;
+    for (char c : ranges) {
+      if (c >= '0' && c <= '9') {
+        current = (in_number ? current * 10 : 0) + (c - '0');
+        in_number = true;
+      } else {
+        in_number = false;
+      }
+      highest = current > highest ? current : highest;
+    }
+    return highest + 1;
+  }();
+  return count;
+}
+
+// Set by numa_pool_scope to use the pools even on single-node machines, so
+// that the pool path can be tested anywhere.
+inline std::atomic<int> forced_pool_scopes{0};
+
+// Whether numa_local_copy allocates from the per-node pools.
+inline bool use_pools() noexcept {
+  return forced_pool_scopes.load(std::memory_order_relaxed) > 0 ||
+         node_count() > 1;
+}
+
+inline int current_node() noexcept {
+#if defined(__linux__) && defined(SYS_getcpu)
+  unsigned cpu = 0;
+  unsigned node = 0;
+  if (syscall(SYS_getcpu, &cpu, &node, nullptr) == 0) {
+    return static_cast<int>(node);
+  }
+#endif
+  return 0;
+}
+
+// Maps `bytes` of fresh memory whose pages the kernel will preferentially
+// place on `node` when they are first touched.
+inline void* map_on_node(std::size_t bytes, int node) {
+#if defined(__linux__) && defined(SYS_mbind)
+  void* p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (p == MAP_FAILED) handle_allocation_failure();
+  constexpr int mpol_preferred = 1;
+  constexpr std::size_t bits = sizeof(unsigned long) * 8;
+  const auto n = static_cast<std::size_t>(node);
+  std::vector<unsigned long> mask(n / bits + 1);
+  mask[n / bits] |= 1ul << (n % bits);
+  // A failed mbind leaves the default first-touch policy, which still places
+  // the pages on the calling thread's node in the common case.
+  (void)syscall(SYS_mbind, p, bytes, mpol_preferred, mask.data(),
+                mask.size() * bits + 1, 0);
+  return p;
+#else
+  (void)node;
+  // Page-aligned, like mmap, so that blocks of any supported alignment fit.
+  return allocate_bytes(bytes, 4096);
+#endif
+}
+
+// A pool of fixed-size blocks for one node. Chunks are carved into blocks and
+// never returned to the system; freed blocks go back on the free list of the
+// node they were allocated from, whichever thread frees them. Each pool has
+// its own cache line so that threads on different nodes do not contend.
+template <std::size_t BlockSize, std::size_t BlockAlign>
+class alignas(64) node_pool {
+  static constexpr std::size_t block_size =
+      (BlockSize + BlockAlign - 1) / BlockAlign * BlockAlign;
+  static constexpr std::size_t chunk_size =
+      block_size * 64 > 65536 ? block_size * 64 : 65536;
+
+  struct free_block {
+    free_block* next;
+  };
+
+ public:
+  static_assert(BlockSize >= sizeof(free_block) &&
+                BlockAlign >= alignof(free_block) && 4096 % BlockAlign == 0);
+
+  // The pool for `node`; pools are intentionally leaked so that values
+  // destroyed during static destruction can still be freed.
+  static node_pool& for_node(int node) {
+    static node_pool* const pools = new node_pool[node_count()];
+    return pools[node];
+  }
+
+  void* allocate(int node) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!free_) refill(node);
+    return std::exchange(free_, free_->next);
+  }
+
+  void deallocate(void* p) noexcept {
+    std::lock_guard<std::mutex> lock(mutex_);
+    free_ = ::new (p) free_block{free_};
+  }
+
+ private:
+  void refill(int node) {
+    auto* chunk = static_cast<unsigned char*>(map_on_node(chunk_size, node));
+    for (std::size_t offset = 0; offset + block_size <= chunk_size;
+         offset += block_size) {
+      free_ = ::new (chunk + offset) free_block{free_};
+    }
+  }
+
+  std::mutex mutex_;
+  free_block* free_ = nullptr;
+};
+
+// Each block starts with the node it came from so that it can be returned to
+// the right pool, or with heap_node if it was allocated with operator new.
+inline constexpr int heap_node = -1;
+
+template <class T>
+struct block_layout {
+  static constexpr std::size_t alignment =
+      alignof(T) > alignof(void*) ? alignof(T) : alignof(void*);
+  static constexpr std::size_t header =
+      (sizeof(int) + alignment - 1) / alignment * alignment;
+  static constexpr std::size_t size = header + sizeof(T);
+  using pool = node_pool<size, alignment>;
+
+  static void* allocate_from_heap() { return allocate_bytes(size, alignment); }
+
+  static void deallocate_to_heap(void* block) noexcept {
+    if constexpr (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+      ::operator delete(block, size, std::align_val_t(alignment));
+    } else {
+      ::operator delete(block, size);
+    }
+  }
+
+  static unsigned char* block_of(const T* p) noexcept {
+    return reinterpret_cast<unsigned char*>(const_cast<T*>(p)) - header;
+  }
+};
+
+// The node recorded for a pointee made by numa_local_copy.
+template <class T>
+int node_of(const T* p) noexcept {
+  return *std::launder(
+      reinterpret_cast<const int*>(block_layout<T>::block_of(p)));
+}
+
+}  // namespace detail::numa
+
+template <class T>
+struct numa_delete {
+  void operator()(T* p) const noexcept {
+    static_assert(0 < sizeof(T), "can't delete an incomplete type");
+    using layout = detail::numa::block_layout<T>;
+    const int node = detail::numa::node_of(p);
+    unsigned char* block = layout::block_of(p);
+    p->~T();
+    if (node == detail::numa::heap_node) {
+      layout::deallocate_to_heap(block);
+    } else {
+      layout::pool::for_node(node).deallocate(block);
+    }
+  }
+};
+
+// A copier that places each copy on the NUMA node of the thread making it.
+//
+// On machines with more than one node, copies are carved from per-node pools
+// whose pages are bound to that node with mbind, so a worker thread that
+// deep-copies shared state gets node-local memory even when the allocator
+// would have reused pages first touched elsewhere. On single-node machines,
+// and where the system calls are unavailable, it behaves like default_copy.
+//
+// Every pointee carries a small header recording where it came from, so
+// numa_delete frees it without any shared lookup. indirect_value's
+// std::in_place constructor creates pointees through construct(); pointers
+// adopted through the raw pointer constructor must also come from construct().
+template <class T>
+struct numa_local_copy {
+  using deleter_type = numa_delete<T>;
+
+  template <class... Ts>
+  T* construct(Ts&&... ts) const {
+    using layout = detail::numa::block_layout<T>;
+    const bool pooled = detail::numa::use_pools();
+    const int node =
+        pooled ? detail::numa::current_node() : detail::numa::heap_node;
+    auto* block = static_cast<unsigned char*>(
+        pooled ? layout::pool::for_node(node).allocate(node)
+               : layout::allocate_from_heap());
+    ::new (block) int(node);
+    ISOCPP_P1950_TRY {
+      return ::new (block + layout::header) T(std::forward<Ts>(ts)...);
+    } ISOCPP_P1950_CATCH_ALL {
+      if (pooled) {
+        layout::pool::for_node(node).deallocate(block);
+      } else {
+        layout::deallocate_to_heap(block);
+      }
+      ISOCPP_P1950_RETHROW;
+    }
+  }
+
+  T* operator()(const T& t) const { return construct(t); }
+};
+
+// Uses the per-node pools for numa_local_copy on every machine for its
+// lifetime, so that tests can exercise them on single-node machines.
+class numa_pool_scope {
+ public:
+  numa_pool_scope() noexcept {
+    detail::numa::forced_pool_scopes.fetch_add(1, std::memory_order_relaxed);
+  }
+  ~numa_pool_scope() {
+    detail::numa::forced_pool_scopes.fetch_sub(1, std::memory_order_relaxed);
+  }
+  numa_pool_scope(const numa_pool_scope&) = delete;
+  numa_pool_scope& operator=(const numa_pool_scope&) = delete;
+};
+
+template <class T, class... Ts>
+indirect_value<T, numa_local_copy<T>> make_numa_local_indirect_value(
+    Ts&&... ts) {
+  return indirect_value<T, numa_local_copy<T>>(
+      numa_local_copy<T>{}.construct(std::forward<Ts>(ts)...));
+}
+
+}  // namespace isocpp_p1950
+
+#endif  // ISOCPP_P1950_NUMA_LOCAL_COPY_H
@@ -0,0 +1,120 @@
+/* Copyright (c) 2019 The Indirect Value Authors. All Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+==============================================================================*/
+
+#include "numa_local_copy.h"
+
+#include <cstdint>
+#include <set>
+#include <string>
+#include <thread>
+
+#include "catch2/catch_test_macros.hpp"
+
+using isocpp_p1950::indirect_value;
+using isocpp_p1950::make_numa_local_indirect_value;
+using isocpp_p1950::numa_local_copy;
+namespace numa = isocpp_p1950::detail::numa;
+
+TEST_CASE("numa_local_copy produces deep copies",
+          "[numa_local_copy.copy]") {
+  GIVEN("An indirect_value created on the current node") {
+    auto a = make_numa_local_indirect_value<std::string>("shared state");
+    WHEN("It is copied on another thread") {
+      indirect_value<std::string, numa_local_copy<std::string>> b;
+      std::thread worker([&] { b = a; });
+      worker.join();
+      THEN("The copy is independent of the original") {
+        REQUIRE(*b == "shared state");
+        REQUIRE(&*b != &*a);
+        *b = "modified";
+        REQUIRE(*a == "shared state");
+      }
+    }
+  }
+}
+
+TEST_CASE("NUMA topology queries are consistent",
+          "[numa_local_copy.topology]") {
+  REQUIRE(numa::node_count() >= 1);
+  REQUIRE(numa::current_node() >= 0);
+  REQUIRE(numa::current_node() < numa::node_count());
+}
+
+TEST_CASE("A node pool hands out distinct aligned blocks",
+          "[numa_local_copy.pool]") {
+  using layout = numa::block_layout<std::string>;
+  auto& pool = layout::pool::for_node(0);
+
+  std::set<void*> blocks;
+  // Enough blocks to need more than one chunk.
+  for (int i = 0; i < 2000; ++i) {
+    void* p = pool.allocate(0);
+    REQUIRE(reinterpret_cast<std::uintptr_t>(p) % layout::alignment == 0);
+    REQUIRE(blocks.insert(p).second);
+  }
+  for (void* p : blocks) pool.deallocate(p);
+
+  void* reused = pool.allocate(0);
+  REQUIRE(blocks.count(reused) == 1);
+  pool.deallocate(reused);
+}
+
+TEST_CASE("Every pointee records where numa_delete must return it",
+          "[numa_local_copy.delete]") {
+  using value = indirect_value<std::string, numa_local_copy<std::string>>;
+  using layout = numa::block_layout<std::string>;
+
+  GIVEN("Values made without the pools") {
+    auto made = make_numa_local_indirect_value<std::string>("made");
+    value in_place(std::in_place, "in place");
+    if (numa::node_count() == 1) {
+      THEN("They come from the heap") {
+        REQUIRE(numa::node_of(&*made) == numa::heap_node);
+        REQUIRE(numa::node_of(&*in_place) == numa::heap_node);
+      }
+    }
+    WHEN("They are copied while the pools are in use") {
+      isocpp_p1950::numa_pool_scope pools;
+      value copy(in_place);
+      THEN("The copy comes from a node's pool") {
+        REQUIRE(numa::node_of(&*copy) >= 0);
+        REQUIRE(*copy == "in place");
+      }
+    }
+  }
+  GIVEN("A value made in place while the pools were in use") {
+    value pooled;
+    {
+      isocpp_p1950::numa_pool_scope pools;
+      pooled = value(std::in_place, "pooled");
+    }
+    const int node = numa::node_of(&*pooled);
+    REQUIRE(node >= 0);
+    WHEN("It is destroyed after the pools are no longer in use") {
+      const void* block = layout::block_of(&*pooled);
+      pooled = value();
+      THEN("Its block is back on the free list of its node's pool") {
+        void* reused = layout::pool::for_node(node).allocate(node);
+        REQUIRE(reused == block);
+        layout::pool::for_node(node).deallocate(reused);
+      }
+    }
+  }
+}
@@ -0,0 +1,702 @@
+/* Copyright (c) 2019 The Indirect Value Authors. All Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+==============================================================================*/
+
+#ifndef ISOCPP_P1950_PAGED_INDIRECT_VALUE_H
+#define ISOCPP_P1950_PAGED_INDIRECT_VALUE_H
+
+#include <cerrno>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <limits>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if __has_include(<unistd.h>)
+#include <fcntl.h>
+#include <unistd.h>
+#define ISOCPP_P1950_HAS_PREAD 1
+#endif
+
+#include "compressed_indirect_value.h"
+#include "indirect_value.h"
+
+namespace isocpp_p1950 {
+
+// The memory a resident T is charged against the spill_store budget.
+// Specialise for types that own heap memory.
+template <class T>
+struct resident_size {
+  std::size_t operator()(const T&) const noexcept { return sizeof(T); }
+};
+
+// Totals for the process-wide spill store. Byte counts cover the values
+// currently alive; the event counts are cumulative.
+struct spill_statistics {
+  std::size_t resident_values = 0;
+  std::size_t resident_bytes = 0;
+  std::size_t spilled_values = 0;
+  std::size_t spilled_bytes = 0;
+  std::size_t file_bytes = 0;
+  std::size_t spills = 0;
+  std::size_t faults = 0;
+  std::size_t prefetches = 0;
+  std::size_t spill_failures = 0;
+};
+
+namespace detail {
+
+[[noreturn]] inline void handle_spill_failure(int error) {
+#ifdef ISOCPP_P1950_NO_EXCEPTIONS
+  (void)error;
+  std::abort();
+#else
+  throw std::system_error(error, std::generic_category(),
+                          "paged_indirect_value spill file");
+#endif
+}
+
+// An unlinked temporary file read and written at explicit offsets.
+class spill_file {
+ public:
+  spill_file() = default;
+  spill_file(const spill_file&) = delete;
+  spill_file& operator=(const spill_file&) = delete;
+
+  ~spill_file() { close(); }
+
+  // Creates the file in `directory` on first use. Returns 0 or an errno.
+  int open(const std::string& directory) {
+#ifdef ISOCPP_P1950_HAS_PREAD
+    if (fd_ >= 0) return 0;
+    std::string path = directory + "/indirect_value_spill_XXXXXX";
+    fd_ = ::mkstemp(path.data());
+    if (fd_ < 0) return errno;
+    ::unlink(path.c_str());
+#else
+    (void)directory;
+    if (file_) return 0;
+    file_ = std::tmpfile();
+    if (!file_) return errno ? errno : EIO;
+#endif
+    return 0;
+  }
+
+  int write(std::uint64_t offset, const unsigned char* data, std::size_t n) {
+#ifdef ISOCPP_P1950_HAS_PREAD
+    while (n != 0) {
+      const ::ssize_t written =
+          ::pwrite(fd_, data, n, static_cast<::off_t>(offset));
+      if (written < 0) {
+        if (errno == EINTR) continue;
+        return errno;
+      }
+      data += written;
+      offset += static_cast<std::uint64_t>(written);
+      n -= static_cast<std::size_t>(written);
+    }
+    return 0;
+#else
+    if (std::fseek(file_, static_cast<long>(offset), SEEK_SET) != 0 ||
+        std::fwrite(data, 1, n, file_) != n) {
+      return EIO;
+    }
+    return 0;
+#endif
+  }
+
+  int read(std::uint64_t offset, unsigned char* data, std::size_t n) const {
+#ifdef ISOCPP_P1950_HAS_PREAD
+    while (n != 0) {
+      const ::ssize_t got = ::pread(fd_, data, n, static_cast<::off_t>(offset));
+      if (got < 0) {
+        if (errno == EINTR) continue;
+        return errno;
+      }
+      if (got == 0) return EIO;
+      data += got;
+      offset += static_cast<std::uint64_t>(got);
+      n -= static_cast<std::size_t>(got);
+    }
+    return 0;
+#else
+    if (std::fseek(file_, static_cast<long>(offset), SEEK_SET) != 0 ||
+        std::fread(data, 1, n, file_) != n) {
+      return EIO;
+    }
+    return 0;
+#endif
+  }
+
+ private:
+  void close() noexcept {
+#ifdef ISOCPP_P1950_HAS_PREAD
+    if (fd_ >= 0) ::close(fd_);
+#else
+    if (file_) std::fclose(file_);
+#endif
+  }
+
+#ifdef ISOCPP_P1950_HAS_PREAD
+  int fd_ = -1;
+#else
+  std::FILE* file_ = nullptr;
+#endif
+};
+
+// The operations the type-erased store needs on a T.
+struct spill_type_ops {
+  void (*serialize)(const void*, std::vector<unsigned char>&);
+  void* (*deserialize)(const unsigned char*, std::size_t);
+  void* (*copy)(const void*);
+  void (*destroy)(void*) noexcept;
+};
+
+template <class T>
+const spill_type_ops* spill_ops_for() noexcept {
+  static constexpr spill_type_ops ops = {
+      [](const void* p, std::vector<unsigned char>& out) {
+        compression_traits<T>::serialize(*static_cast<const T*>(p), out);
+      },
+      [](const unsigned char* data, std::size_t n) -> void* {
+        return new_object<T>(compression_traits<T>::deserialize(data, n));
+      },
+      [](const void* p) -> void* {
+        return new_object<T>(*static_cast<const T*>(p));
+      },
+      [](void* p) noexcept { delete static_cast<T*>(p); },
+  };
+  return &ops;
+}
+
+// One paged value. All fields are guarded by the spill_state mutex.
+struct spill_entry {
+  explicit spill_entry(const spill_type_ops* o) noexcept : ops(o) {}
+
+  const spill_type_ops* ops;
+  // The resident object, or null while the value is only on disk.
+  void* object = nullptr;
+  std::size_t resident_bytes = 0;
+  // The extent of the file holding the serialised value, if any.
+  std::uint64_t offset = 0;
+  std::size_t length = 0;
+  bool has_extent = false;
+  // Whether the resident object may differ from the extent.
+  bool dirty = true;
+  bool released = false;
+  std::size_t pins = 0;
+  std::list<spill_entry*>::iterator lru;
+};
+
+// The process-wide state behind spill_store: the resident values in
+// least-recently-used order, the spill file and its free extents, and the
+// prefetch queue. File I/O is performed under the lock; the store is meant
+// for cold data, where contention is rare.
+class spill_state {
+ public:
+  static spill_state& instance() {
+    // Never destroyed, so that paged values with static storage duration
+    // and the detached prefetch thread can still use it during exit.
+    static auto* state = new spill_state;
+    return *state;
+  }
+
+  std::mutex mutex;
+
+  std::size_t budget = std::numeric_limits<std::size_t>::max();
+  std::string directory = default_directory();
+  spill_statistics stats;
+
+  // Makes a resident entry holding `object`.
+  std::shared_ptr<spill_entry> admit(const spill_type_ops* ops, void* object,
+                                     std::size_t bytes) {
+    std::shared_ptr<spill_entry> e;
+    ISOCPP_P1950_TRY { e = std::make_shared<spill_entry>(ops); }
+    ISOCPP_P1950_CATCH_ALL {
+      ops->destroy(object);
+      ISOCPP_P1950_RETHROW;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    make_resident(*e, object, bytes);
+    enforce_budget();
+    return e;
+  }
+
+  // Makes a copy of `source`. A spilled source is copied extent to extent,
+  // without deserialising it.
+  std::shared_ptr<spill_entry> copy(const spill_entry& source) {
+    auto e = std::make_shared<spill_entry>(source.ops);
+    std::unique_lock<std::mutex> lock(mutex);
+    if (source.object) {
+      const std::size_t bytes = source.resident_bytes;
+      // Pins the source so that it is not evicted while it is copied.
+      auto& pinned = const_cast<spill_entry&>(source);
+      ++pinned.pins;
+      lock.unlock();
+      void* object = nullptr;
+      ISOCPP_P1950_TRY { object = source.ops->copy(source.object); }
+      ISOCPP_P1950_CATCH_ALL {
+        unpin(pinned, false, 0);
+        ISOCPP_P1950_RETHROW;
+      }
+      lock.lock();
+      --pinned.pins;
+      make_resident(*e, object, bytes);
+      enforce_budget();
+      return e;
+    }
+    buffer.resize(source.length);
+    if (const int error = file.read(source.offset, buffer.data(),
+                                    source.length)) {
+      handle_spill_failure(error);
+    }
+    const std::uint64_t offset = allocate_extent(source.length);
+    if (const int error = file.write(offset, buffer.data(), source.length)) {
+      free_extent(offset, source.length);
+      handle_spill_failure(error);
+    }
+    e->offset = offset;
+    e->length = source.length;
+    e->has_extent = true;
+    e->dirty = false;
+    // Faulting the copy in charges it at the size the source was spilled at.
+    e->resident_bytes = source.resident_bytes;
+    ++stats.spilled_values;
+    stats.spilled_bytes += source.length;
+    return e;
+  }
+
+  // Destroys the value and returns its memory and extent.
+  void release(spill_entry& e) noexcept {
+    std::lock_guard<std::mutex> lock(mutex);
+    e.released = true;
+    if (e.object) {
+      evict_from_memory(e);
+    } else if (e.has_extent) {
+      --stats.spilled_values;
+      stats.spilled_bytes -= e.length;
+    }
+    if (e.has_extent) free_extent(e.offset, e.length);
+    e.has_extent = false;
+  }
+
+  // Makes the value resident, if it is not, and keeps it resident until
+  // unpin.
+  void* pin(spill_entry& e) {
+    std::lock_guard<std::mutex> lock(mutex);
+    fault_in(e);
+    ++e.pins;
+    touch(e);
+    enforce_budget();
+    return e.object;
+  }
+
+  // Releases a pin. A modified value is marked dirty and recharged at
+  // `bytes`.
+  void unpin(spill_entry& e, bool modified, std::size_t bytes) noexcept {
+    std::lock_guard<std::mutex> lock(mutex);
+    --e.pins;
+    if (modified) {
+      e.dirty = true;
+      stats.resident_bytes = stats.resident_bytes - e.resident_bytes + bytes;
+      e.resident_bytes = bytes;
+    }
+    enforce_budget();
+  }
+
+  bool resident(const spill_entry& e) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return e.object != nullptr;
+  }
+
+  void set_budget(std::size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex);
+    budget = bytes;
+    enforce_budget();
+  }
+
+  void prefetch(std::shared_ptr<spill_entry> e) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (e->object || e->released) return;
+    if (!worker_started) {
+      std::thread([this] { run_prefetches(); }).detach();
+      worker_started = true;
+    }
+    queue.push_back(std::move(e));
+    ++pending;
+    work.notify_one();
+  }
+
+  void wait_for_prefetches() {
+    std::unique_lock<std::mutex> lock(mutex);
+    drained.wait(lock, [this] { return pending == 0; });
+  }
+
+ private:
+  spill_file file;
+  bool file_open = false;
+  std::uint64_t file_end = 0;
+  std::multimap<std::size_t, std::uint64_t> free_extents;
+  std::list<spill_entry*> lru;
+  std::vector<unsigned char> buffer;
+
+  std::deque<std::shared_ptr<spill_entry>> queue;
+  std::size_t pending = 0;
+  bool worker_started = false;
+  std::condition_variable work;
+  std::condition_variable drained;
+
+  static std::string default_directory() {
+    if (const char* tmp = std::getenv("TMPDIR")) return tmp;
+    return "/tmp";
+  }
+
+  // Takes ownership of `object`, destroying it if the entry cannot be
+  // tracked.
+  void make_resident(spill_entry& e, void* object, std::size_t bytes) {
+    ISOCPP_P1950_TRY { lru.push_front(&e); }
+    ISOCPP_P1950_CATCH_ALL {
+      e.ops->destroy(object);
+      ISOCPP_P1950_RETHROW;
+    }
+    e.lru = lru.begin();
+    e.object = object;
+    e.resident_bytes = bytes;
+    ++stats.resident_values;
+    stats.resident_bytes += bytes;
+  }
+
+  void touch(spill_entry& e) noexcept {
+    lru.splice(lru.begin(), lru, e.lru);
+  }
+
+  void evict_from_memory(spill_entry& e) noexcept {
+    lru.erase(e.lru);
+    e.ops->destroy(e.object);
+    e.object = nullptr;
+    --stats.resident_values;
+    stats.resident_bytes -= e.resident_bytes;
+  }
+
+  void fault_in(spill_entry& e) {
+    if (e.object) return;
+    buffer.resize(e.length);
+    if (const int error = file.read(e.offset, buffer.data(), e.length)) {
+      handle_spill_failure(error);
+    }
+    void* object = e.ops->deserialize(buffer.data(), e.length);
+    // Charged at the size it had when it was spilled.
+    make_resident(e, object, e.resident_bytes);
+    e.dirty = false;
+    --stats.spilled_values;
+    stats.spilled_bytes -= e.length;
+    ++stats.faults;
+  }
+
+  std::uint64_t allocate_extent(std::size_t length) {
+    auto it = free_extents.lower_bound(length);
+    if (it == free_extents.end()) {
+      const std::uint64_t offset = file_end;
+      file_end += length;
+      stats.file_bytes = static_cast<std::size_t>(file_end);
+      return offset;
+    }
+    const std::size_t size = it->first;
+    const std::uint64_t offset = it->second;
+    free_extents.erase(it);
+    if (size > length) free_extents.emplace(size - length, offset + length);
+    return offset;
+  }
+
+  void free_extent(std::uint64_t offset, std::size_t length) noexcept {
+    if (length == 0) return;
+    ISOCPP_P1950_TRY { free_extents.emplace(length, offset); }
+    ISOCPP_P1950_CATCH_ALL {
+      // Losing track of an extent only wastes file space.
+    }
+  }
+
+  // Writes the value to the file, if the file does not already hold it, and
+  // destroys the resident object. Returns false if the write failed.
+  bool spill(spill_entry& e) noexcept {
+    if (e.dirty || !e.has_extent) {
+      ISOCPP_P1950_TRY {
+        if (!file_open) {
+          if (file.open(directory) != 0) return false;
+          file_open = true;
+        }
+        buffer.clear();
+        e.ops->serialize(e.object, buffer);
+        const std::uint64_t offset = allocate_extent(buffer.size());
+        if (file.write(offset, buffer.data(), buffer.size()) != 0) {
+          free_extent(offset, buffer.size());
+          return false;
+        }
+        if (e.has_extent) free_extent(e.offset, e.length);
+        e.offset = offset;
+        e.length = buffer.size();
+        e.has_extent = true;
+        e.dirty = false;
+      }
+      ISOCPP_P1950_CATCH_ALL { return false; }
+    }
+    evict_from_memory(e);
+    ++stats.spilled_values;
+    stats.spilled_bytes += e.length;
+    ++stats.spills;
+    return true;
+  }
+
+  // Spills the least recently used unpinned values until the resident
+  // values fit the budget. A failed spill leaves the value resident and
+  // stops eviction until the next attempt.
+  void enforce_budget() noexcept {
+    auto it = lru.end();
+    while (stats.resident_bytes > budget && it != lru.begin()) {
+      spill_entry& e = **--it;
+      if (e.pins != 0) continue;
+      auto next = std::next(it);
+      if (!spill(e)) {
+        ++stats.spill_failures;
+        return;
+      }
+      it = next;
+    }
+  }
+
+  void run_prefetches() {
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+      work.wait(lock, [this] { return !queue.empty(); });
+      std::shared_ptr<spill_entry> e = std::move(queue.front());
+      queue.pop_front();
+      if (!e->released && !e->object) {
+        ISOCPP_P1950_TRY {
+          fault_in(*e);
+          ++stats.prefetches;
+          enforce_budget();
+        }
+        ISOCPP_P1950_CATCH_ALL {
+          // The value is faulted in again, reporting the error, on access.
+        }
+      }
+      if (--pending == 0) drained.notify_all();
+      // Drops the reference outside the lock; releasing may free the entry.
+      lock.unlock();
+      e.reset();
+      lock.lock();
+    }
+  }
+};
+
+}  // namespace detail
+
+// Configuration and statistics for the process-wide store behind every
+// paged_indirect_value.
+class spill_store {
+ public:
+  // Sets the resident budget in bytes, spilling least recently used values
+  // to the spill file until the resident values fit. The default is
+  // unlimited, so nothing is spilled until a budget is set.
+  static void set_resident_budget(std::size_t bytes) {
+    detail::spill_state::instance().set_budget(bytes);
+  }
+
+  static std::size_t resident_budget() {
+    auto& state = detail::spill_state::instance();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    return state.budget;
+  }
+
+  // Sets the directory in which the spill file is created. Only effective
+  // before the first value is spilled. Defaults to $TMPDIR or /tmp.
+  static void set_spill_directory(std::string directory) {
+    auto& state = detail::spill_state::instance();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    state.directory = std::move(directory);
+  }
+
+  static spill_statistics statistics() {
+    auto& state = detail::spill_state::instance();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    return state.stats;
+  }
+
+  // Blocks until every prefetch requested so far has completed.
+  static void wait_for_prefetches() {
+    detail::spill_state::instance().wait_for_prefetches();
+  }
+};
+
+// A value-semantic owner of a T that may be spilled to a local file when the
+// resident values exceed the spill_store budget.
+//
+// Values are serialised with compression_traits<T>, the customisation point
+// shared with compressed_indirect_value, and charged against the budget at
+// resident_size<T>. Dereferencing pins the value in memory for the lifetime
+// of the returned guard, faulting it back in with pread if it was spilled;
+// `v->member` pins it for the full expression. Guards from a non-const
+// paged_indirect_value give mutable access and mark the value for rewriting
+// when it is next spilled; use read() for const access to a non-const value.
+// prefetch() faults a spilled value in on a background thread.
+//
+// Copying a resident value copies the T; copying a spilled value copies its
+// bytes within the spill file, without faulting it in. Like indirect_value,
+// a default constructed paged_indirect_value is empty.
+template <class T>
+class paged_indirect_value {
+  std::shared_ptr<detail::spill_entry> entry_;
+
+  template <bool Const>
+  class guard {
+    using pointer = std::conditional_t<Const, const T*, T*>;
+    using reference = std::conditional_t<Const, const T&, T&>;
+
+   public:
+    guard(const guard&) = delete;
+    guard& operator=(const guard&) = delete;
+
+    ~guard() {
+      const std::size_t bytes = Const ? 0 : resident_size<T>{}(*p_);
+      detail::spill_state::instance().unpin(*entry_, !Const, bytes);
+    }
+
+    reference operator*() const noexcept { return *p_; }
+    pointer operator->() const noexcept { return p_; }
+
+   private:
+    friend class paged_indirect_value;
+
+    explicit guard(detail::spill_entry& e)
+        : entry_(&e),
+          p_(static_cast<T*>(detail::spill_state::instance().pin(e))) {}
+
+    detail::spill_entry* entry_;
+    T* p_;
+  };
+
+ public:
+  using value_type = T;
+  using const_access_guard = guard<true>;
+  using access_guard = guard<false>;
+
+  paged_indirect_value() noexcept = default;
+
+  template <class... Ts>
+  explicit paged_indirect_value(std::in_place_t, Ts&&... ts)
+      : entry_(admit(detail::new_object<T>(std::forward<Ts>(ts)...))) {}
+
+  explicit paged_indirect_value(const T& value)
+      : entry_(admit(detail::new_object<T>(value))) {}
+
+  explicit paged_indirect_value(T&& value)
+      : entry_(admit(detail::new_object<T>(std::move(value)))) {}
+
+  paged_indirect_value(const paged_indirect_value& other)
+      : entry_(other.entry_
+                   ? detail::spill_state::instance().copy(*other.entry_)
+                   : nullptr) {}
+
+  paged_indirect_value(paged_indirect_value&& other) noexcept = default;
+
+  paged_indirect_value& operator=(const paged_indirect_value& other) {
+    if (this != &other) paged_indirect_value(other).swap(*this);
+    return *this;
+  }
+
+  paged_indirect_value& operator=(paged_indirect_value&& other) noexcept {
+    if (this != &other) paged_indirect_value(std::move(other)).swap(*this);
+    return *this;
+  }
+
+  ~paged_indirect_value() {
+    if (entry_) detail::spill_state::instance().release(*entry_);
+  }
+
+  const_access_guard operator*() const { return read(); }
+
+  const_access_guard operator->() const { return read(); }
+
+  access_guard operator*() { return write(); }
+
+  access_guard operator->() { return write(); }
+
+  // Pins the value with const access. Requires a value.
+  const_access_guard read() const { return const_access_guard(*entry_); }
+
+  // Pins the value with mutable access. Requires a value.
+  access_guard write() { return access_guard(*entry_); }
+
+  // A copy of the value.
+  T value() const {
+    if (!entry_) detail::handle_bad_access();
+    return *read();
+  }
+
+  // Starts faulting a spilled value back in on a background thread.
+  void prefetch() const {
+    if (entry_) detail::spill_state::instance().prefetch(entry_);
+  }
+
+  // Whether the value is currently in memory. Other threads may spill or
+  // fault it in concurrently.
+  bool resident() const {
+    return entry_ && detail::spill_state::instance().resident(*entry_);
+  }
+
+  bool has_value() const noexcept { return entry_ != nullptr; }
+
+  explicit operator bool() const noexcept { return entry_ != nullptr; }
+
+  void swap(paged_indirect_value& other) noexcept {
+    entry_.swap(other.entry_);
+  }
+
+  friend void swap(paged_indirect_value& lhs,
+                   paged_indirect_value& rhs) noexcept {
+    lhs.swap(rhs);
+  }
+
+ private:
+  static std::shared_ptr<detail::spill_entry> admit(T* object) {
+    const std::size_t bytes = resident_size<T>{}(*object);
+    return detail::spill_state::instance().admit(
+        detail::spill_ops_for<T>(), object, bytes);
+  }
+};
+
+template <class T, class... Ts>
+paged_indirect_value<T> make_paged_indirect_value(Ts&&... ts) {
+  return paged_indirect_value<T>(std::in_place, std::forward<Ts>(ts)...);
+}
+
+}  // namespace isocpp_p1950
+
+#endif  // ISOCPP_P1950_PAGED_INDIRECT_VALUE_H
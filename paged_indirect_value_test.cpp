@@ -0,0 +1,230 @@
+/* Copyright (c) 2019 The Indirect Value Authors. All Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+==============================================================================*/
+
+#include "paged_indirect_value.h"
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "catch2/catch_test_macros.hpp"
+
+using isocpp_p1950::make_paged_indirect_value;
+using isocpp_p1950::paged_indirect_value;
+using isocpp_p1950::spill_store;
+
+namespace {
+struct Page {
+  std::array<std::uint64_t, 512> words{};
+
+  explicit Page(std::uint64_t seed = 0) {
+    for (std::size_t i = 0; i < words.size(); ++i) words[i] = seed * 1000 + i;
+  }
+};
+
+struct Note {
+  std::string text;
+};
+
+// Restores an unlimited budget when a test ends.
+struct budget_scope {
+  explicit budget_scope(std::size_t bytes) {
+    spill_store::set_resident_budget(bytes);
+  }
+  ~budget_scope() {
+    spill_store::set_resident_budget(static_cast<std::size_t>(-1));
+  }
+};
+
+std::size_t resident_count(const std::vector<paged_indirect_value<Page>>& v) {
+  std::size_t n = 0;
+  for (const auto& p : v) n += p.resident() ? 1 : 0;
+  return n;
+}
+}  // namespace
+
+template <>
+struct isocpp_p1950::compression_traits<Note> {
+  static void serialize(const Note& n, std::vector<unsigned char>& out) {
+    out.assign(n.text.begin(), n.text.end());
+  }
+
+  static Note deserialize(const unsigned char* data, std::size_t size) {
+    return Note{std::string(reinterpret_cast<const char*>(data), size)};
+  }
+};
+
+template <>
+struct isocpp_p1950::resident_size<Note> {
+  std::size_t operator()(const Note& n) const noexcept {
+    return sizeof(Note) + n.text.capacity();
+  }
+};
+
+TEST_CASE("paged_indirect_value stays resident without a budget",
+          "[paged_indirect_value.unlimited]") {
+  auto v = make_paged_indirect_value<Page>(3);
+  REQUIRE(v.has_value());
+  REQUIRE(v.resident());
+  REQUIRE(v->words[1] == 3001);
+  REQUIRE(!paged_indirect_value<Page>());
+}
+
+TEST_CASE("Values beyond the budget are spilled and faulted back in",
+          "[paged_indirect_value.spill]") {
+  budget_scope budget(4 * sizeof(Page));
+  const auto before = spill_store::statistics();
+
+  std::vector<paged_indirect_value<Page>> pages;
+  for (std::uint64_t i = 0; i < 16; ++i) pages.emplace_back(std::in_place, i);
+
+  THEN("Only the most recently used values stay resident") {
+    REQUIRE(resident_count(pages) == 4);
+    REQUIRE(pages.back().resident());
+    REQUIRE(!pages.front().resident());
+    const auto s = spill_store::statistics();
+    REQUIRE(s.resident_values - before.resident_values == 4);
+    REQUIRE(s.spilled_values - before.spilled_values == 12);
+    REQUIRE(s.spilled_bytes - before.spilled_bytes == 12 * sizeof(Page));
+  }
+  THEN("Access faults a value back in, spilling another") {
+    const auto& first = pages.front();
+    REQUIRE(first->words[7] == 7);
+    REQUIRE(first.resident());
+    REQUIRE(resident_count(pages) == 4);
+    REQUIRE(spill_store::statistics().faults > before.faults);
+  }
+  THEN("Every value survives the round trip") {
+    for (std::uint64_t i = 0; i < 16; ++i) {
+      REQUIRE(pages[i].value().words[511] == i * 1000 + 511);
+    }
+  }
+  THEN("Modifications are written back when spilled again") {
+    pages[0].write()->words[0] = 42;
+    for (std::uint64_t i = 1; i < 16; ++i) (void)pages[i].read()->words[0];
+    REQUIRE(!pages[0].resident());
+    REQUIRE(pages[0].read()->words[0] == 42);
+  }
+  THEN("A pinned value is not spilled") {
+    auto guard = pages.front().read();
+    for (std::uint64_t i = 1; i < 16; ++i) (void)pages[i].read()->words[0];
+    REQUIRE(pages.front().resident());
+    REQUIRE(guard->words[2] == 2);
+  }
+}
+
+TEST_CASE("Copies of spilled values stay on disk",
+          "[paged_indirect_value.copy]") {
+  budget_scope budget(2 * sizeof(Page));
+  std::vector<paged_indirect_value<Page>> pages;
+  for (std::uint64_t i = 0; i < 4; ++i) pages.emplace_back(std::in_place, i);
+  REQUIRE(!pages.front().resident());
+
+  GIVEN("A copy of a spilled value") {
+    const auto faults = spill_store::statistics().faults;
+    paged_indirect_value<Page> copy(pages.front());
+    THEN("It is made without faulting the source in") {
+      REQUIRE(!pages.front().resident());
+      REQUIRE(!copy.resident());
+      REQUIRE(spill_store::statistics().faults == faults);
+    }
+    THEN("It is independent of the source") {
+      copy.write()->words[0] = 99;
+      REQUIRE(pages.front()->words[0] == 0);
+      REQUIRE(copy->words[0] == 99);
+    }
+  }
+  GIVEN("Copies of a spilled value that are read") {
+    std::vector<paged_indirect_value<Page>> copies(10, pages.front());
+    for (const auto& c : copies) REQUIRE(c->words[5] == 5);
+    THEN("They are charged against the budget like their source") {
+      const auto s = spill_store::statistics();
+      REQUIRE(s.resident_bytes <= 2 * sizeof(Page));
+      REQUIRE(s.resident_bytes == s.resident_values * sizeof(Page));
+      REQUIRE(resident_count(copies) + resident_count(pages) == 2);
+    }
+  }
+  GIVEN("A copy of a resident value") {
+    paged_indirect_value<Page> copy(pages.back());
+    REQUIRE(copy.resident());
+    REQUIRE(copy->words[3] == 3003);
+  }
+  GIVEN("Assignment, move and swap") {
+    paged_indirect_value<Page> a;
+    a = pages[0];
+    auto b = std::move(a);
+    REQUIRE(!a);
+    swap(a, b);
+    REQUIRE(a.value().words[1] == 1);
+  }
+}
+
+TEST_CASE("Prefetching faults values in on a background thread",
+          "[paged_indirect_value.prefetch]") {
+  budget_scope budget(4 * sizeof(Page));
+  std::vector<paged_indirect_value<Page>> pages;
+  for (std::uint64_t i = 0; i < 8; ++i) pages.emplace_back(std::in_place, i);
+  REQUIRE(!pages[0].resident());
+  REQUIRE(!pages[1].resident());
+
+  const auto before = spill_store::statistics().prefetches;
+  pages[0].prefetch();
+  pages[1].prefetch();
+  spill_store::wait_for_prefetches();
+  REQUIRE(pages[0].resident());
+  REQUIRE(pages[1].resident());
+  REQUIRE(spill_store::statistics().prefetches == before + 2);
+
+  GIVEN("A value destroyed before its prefetch runs") {
+    pages[2].prefetch();
+    pages.erase(pages.begin() + 2);
+    spill_store::wait_for_prefetches();
+    REQUIRE(resident_count(pages) <= 4);
+  }
+}
+
+TEST_CASE("Types with heap memory use the customisation points",
+          "[paged_indirect_value.traits]") {
+  const std::string text(4000, 'n');
+  budget_scope budget(2 * (sizeof(Note) + text.size()));
+  std::vector<paged_indirect_value<Note>> notes;
+  for (int i = 0; i < 4; ++i) {
+    notes.emplace_back(Note{text + std::to_string(i)});
+  }
+  REQUIRE(!notes[0].resident());
+  REQUIRE(notes[0]->text.size() == 4001);
+  notes[1].write()->text = "short";
+  REQUIRE(notes[1].value().text == "short");
+  REQUIRE(notes[3].value().text.back() == '3');
+}
+
+TEST_CASE("Lowering the budget spills immediately",
+          "[paged_indirect_value.budget]") {
+  std::vector<paged_indirect_value<Page>> pages;
+  for (std::uint64_t i = 0; i < 4; ++i) pages.emplace_back(std::in_place, i);
+  REQUIRE(resident_count(pages) == 4);
+  budget_scope budget(sizeof(Page));
+  REQUIRE(spill_store::resident_budget() == sizeof(Page));
+  REQUIRE(resident_count(pages) == 1);
+  REQUIRE(pages[3].resident());
+}
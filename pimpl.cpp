@@ -53,4 +53,31 @@ example_pimpl::example_pimpl(example_pimpl&& rhs) noexcept = default;
 example_pimpl::example_pimpl(const example_pimpl& rhs) = default;
 example_pimpl& example_pimpl::operator=(example_pimpl&& rhs) noexcept = default;
 example_pimpl& example_pimpl::operator=(const example_pimpl& rhs) = default;
-example_pimpl::~example_pimpl() = default;
\ No newline at end of file
+example_pimpl::~example_pimpl() = default;
+
+example_fast_pimpl::example_fast_pimpl() : pimpl_(std::in_place) {}
+
+example_fast_pimpl::example_fast_pimpl(char const* const name)
+    : pimpl_(std::in_place) {
+  assert(name);
+  pimpl_->set_name(name);
+}
+
+char const* const example_fast_pimpl::get_name() const noexcept {
+  assert(!pimpl_->get_name().empty());
+  return pimpl_->get_name().c_str();
+}
+
+void example_fast_pimpl::set_name(char const* const name) {
+  assert(name);
+  pimpl_->set_name(name);
+}
+
+example_fast_pimpl::example_fast_pimpl(example_fast_pimpl&& rhs) noexcept =
+    default;
+example_fast_pimpl::example_fast_pimpl(const example_fast_pimpl& rhs) = default;
+example_fast_pimpl& example_fast_pimpl::operator=(
+    example_fast_pimpl&& rhs) noexcept = default;
+example_fast_pimpl& example_fast_pimpl::operator=(
+    const example_fast_pimpl& rhs) = default;
+example_fast_pimpl::~example_fast_pimpl() = default;
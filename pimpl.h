@@ -21,6 +21,7 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #ifndef INDIRECT_VALUE_EXAMPLE_PIMPL_H
 #define INDIRECT_VALUE_EXAMPLE_PIMPL_H
 
+#include "fast_pimpl.h"
 #include "indirect_value.h"
 
 class example_pimpl {
@@ -43,4 +44,26 @@ class example_pimpl {
   isocpp_p1950::indirect_value<class pimpl> pimpl_;
 };
 
+// The same class with the implementation stored inline rather than on the
+// heap. The buffer size is checked against the complete type in pimpl.cpp.
+class example_fast_pimpl {
+ public:
+  example_fast_pimpl();
+  example_fast_pimpl(char const* const name);
+  example_fast_pimpl(example_fast_pimpl&& rhs) noexcept;
+  example_fast_pimpl(const example_fast_pimpl& rhs);
+  example_fast_pimpl& operator=(example_fast_pimpl&& rhs) noexcept;
+  example_fast_pimpl& operator=(const example_fast_pimpl& rhs);
+  ~example_fast_pimpl();
+
+  const bool is_valid() const noexcept { return static_cast<bool>(pimpl_); }
+
+  // Abstract string representation for ABI safety.
+  char const* const get_name() const noexcept;
+  void set_name(char const* const name);
+
+ private:
+  isocpp_p1950::fast_pimpl<class pimpl, 40, alignof(void*)> pimpl_;
+};
+
 #endif  // INDIRECT_VALUE_EXAMPLE_PIMPL_H
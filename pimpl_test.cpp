@@ -20,12 +20,14 @@ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #include "pimpl.h"
 
+#include "catch2/catch_template_test_macros.hpp"
 #include "catch2/catch_test_macros.hpp"
 
-TEST_CASE(
+TEMPLATE_TEST_CASE(
     "Basic life time operations of a pimpl now work for free via "
     "indirect_value via the rule of zero",
-    "[example_pimpl.life_cycle]") {
+    "[example_pimpl.life_cycle]", example_pimpl, example_fast_pimpl) {
+  using example_pimpl = TestType;
   GIVEN("An instance of the pimpl type") {
     const std::string nameA = "First Pimpl";
     example_pimpl a;
@@ -40,11 +42,11 @@ TEST_CASE(
       }
     }
     WHEN("Moving constructing an instance.") {
-      const auto string_location = a.get_name();
+      const std::string original_name = a.get_name();
       example_pimpl b(std::move(a));
 
       THEN("Ensure the moved class has the contents of the original") {
-        REQUIRE(std::string(b.get_name()) == std::string(string_location));
+        REQUIRE(std::string(b.get_name()) == original_name);
         REQUIRE(a.is_valid() == false);
       }
     }
@@ -60,13 +62,19 @@ TEST_CASE(
     }
     WHEN("Moving assigning across to a default constructed instance.") {
       example_pimpl b;
-      const auto string_location = a.get_name();
+      const std::string original_name = a.get_name();
       b = std::move(a);
 
       THEN("Ensure the moved class has the contents of the original") {
-        REQUIRE(std::string(b.get_name()) == std::string(string_location));
+        REQUIRE(std::string(b.get_name()) == original_name);
         REQUIRE(a.is_valid() == false);
       }
     }
   }
-}
\ No newline at end of file
+}
+
+TEST_CASE("A fast_pimpl stores its implementation inline",
+          "[example_fast_pimpl.sizeof]") {
+  STATIC_REQUIRE(sizeof(example_fast_pimpl) > sizeof(example_pimpl));
+  STATIC_REQUIRE(sizeof(example_fast_pimpl) <= 40 + alignof(void*));
+}
@@ -0,0 +1,169 @@
+/* Copyright (c) 2019 The Indirect Value Authors. All Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+==============================================================================*/
+
+#ifndef ISOCPP_P1950_RECYCLING_COPY_H
+#define ISOCPP_P1950_RECYCLING_COPY_H
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+
+#include "indirect_value.h"
+
+namespace isocpp_p1950 {
+
+// A bounded, per-thread cache of live T objects released by
+// recycling_delete<T> and reused by recycling_copy<T>.
+//
+// Cached objects are not destroyed, so any capacity they own (a vector's
+// buffer, a string's heap storage) is kept for the next copy. The cache is
+// emptied, running the destructors, when the thread exits or when trim() or
+// set_limit() shrink it.
+template <class T>
+class recycling_cache {
+ public:
+  static constexpr std::size_t default_limit = 32;
+
+  // The maximum number of objects this thread retains.
+  static std::size_t limit() noexcept {
+    return destroyed() ? 0 : instance().limit_;
+  }
+
+  // Changes this thread's limit, destroying objects beyond the new limit.
+  static void set_limit(std::size_t n) noexcept {
+    if (destroyed()) return;
+    auto& cache = instance();
+    cache.trim_to(n);
+    cache.limit_ = n;
+  }
+
+  // The number of objects this thread currently retains.
+  static std::size_t size() noexcept {
+    return destroyed() ? 0 : instance().size_;
+  }
+
+  // Destroys retained objects until at most `keep` remain.
+  static void trim(std::size_t keep = 0) noexcept {
+    if (!destroyed()) instance().trim_to(keep);
+  }
+
+  // Takes a retained object out of the cache, or returns nullptr.
+  static T* acquire() noexcept {
+    if (destroyed()) return nullptr;
+    auto& cache = instance();
+    return cache.size_ ? cache.slots_[--cache.size_] : nullptr;
+  }
+
+  // Retains `p` if there is room and returns true; otherwise returns false
+  // and the caller keeps ownership.
+  static bool release(T* p) noexcept {
+    if (destroyed()) return false;
+    auto& cache = instance();
+    if (cache.size_ >= cache.limit_) return false;
+    if (cache.size_ == cache.capacity_ && !cache.grow()) return false;
+    cache.slots_[cache.size_++] = p;
+    return true;
+  }
+
+ private:
+  recycling_cache() = default;
+  ~recycling_cache() {
+    trim_to(0);
+    // Objects released by thread_local values destroyed after the cache are
+    // deleted rather than retained.
+    destroyed() = true;
+  }
+
+  // Set once this thread's cache has been destroyed. A bool with a constant
+  // initialiser has no destructor, so it stays usable while the thread's
+  // other thread_local objects are destroyed.
+  static bool& destroyed() noexcept {
+    thread_local bool flag = false;
+    return flag;
+  }
+
+  static recycling_cache& instance() noexcept {
+    thread_local recycling_cache cache;
+    return cache;
+  }
+
+  // Makes room for limit_ objects. Allocation failure just disables
+  // recycling for the object being released.
+  bool grow() noexcept {
+    std::unique_ptr<T*[]> slots(new (std::nothrow) T*[limit_]);
+    if (!slots) return false;
+    std::copy(slots_.get(), slots_.get() + size_, slots.get());
+    slots_ = std::move(slots);
+    capacity_ = limit_;
+    return true;
+  }
+
+  void trim_to(std::size_t keep) noexcept {
+    while (size_ > keep) delete slots_[--size_];
+  }
+
+  std::unique_ptr<T*[]> slots_;
+  std::size_t capacity_ = 0;
+  std::size_t size_ = 0;
+  std::size_t limit_ = default_limit;
+};
+
+// Returns the pointee to this thread's recycling_cache<T> instead of
+// destroying it. Objects that do not fit are deleted.
+template <class T>
+struct recycling_delete {
+  void operator()(T* p) const noexcept {
+    static_assert(0 < sizeof(T), "can't delete an incomplete type");
+    if (p && !recycling_cache<T>::release(p)) delete p;
+  }
+};
+
+// Copies into an object taken from this thread's recycling_cache<T> by copy
+// assignment, so that the retained object's capacity is reused. Allocates a
+// new T only when the cache is empty.
+//
+// Pointees must be allocated with new, as by the std::in_place constructor of
+// indirect_value, because recycling_delete<T> deletes surplus objects.
+template <class T>
+struct recycling_copy {
+  using deleter_type = recycling_delete<T>;
+
+  T* operator()(const T& t) const {
+    T* p = recycling_cache<T>::acquire();
+    if (!p) return detail::new_object<T>(t);
+    ISOCPP_P1950_TRY { *p = t; }
+    ISOCPP_P1950_CATCH_ALL {
+      // A failed assignment leaves a valid object, which can still be reused.
+      recycling_delete<T>()(p);
+      ISOCPP_P1950_RETHROW;
+    }
+    return p;
+  }
+};
+
+template <class T>
+using recycling_indirect_value =
+    indirect_value<T, recycling_copy<T>, recycling_delete<T>>;
+
+}  // namespace isocpp_p1950
+
+#endif  // ISOCPP_P1950_RECYCLING_COPY_H
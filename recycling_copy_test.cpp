@@ -0,0 +1,159 @@
+/* Copyright (c) 2019 The Indirect Value Authors. All Rights Reserved.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of
+this software and associated documentation files (the "Software"), to deal in
+the Software without restriction, including without limitation the rights to
+use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+the Software, and to permit persons to whom the Software is furnished to do so,
+subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+==============================================================================*/
+
+#include "recycling_copy.h"
+
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "allocation_counting.h"
+#include "catch2/catch_test_macros.hpp"
+
+using isocpp_p1950::recycling_cache;
+using isocpp_p1950::recycling_indirect_value;
+using isocpp_p1950::testing::count_allocations;
+
+namespace {
+struct Buffer {
+  std::vector<int> data;
+
+  Buffer() { ++live; }
+  explicit Buffer(std::size_t n) : data(n) { ++live; }
+  Buffer(const Buffer& b) : data(b.data) { ++live; }
+  Buffer& operator=(const Buffer&) = default;
+  ~Buffer() { --live; }
+
+  inline static int live = 0;
+};
+
+using cache = recycling_cache<Buffer>;
+}  // namespace
+
+TEST_CASE("Destroyed pointees are retained without being destroyed",
+          "[recycling_copy.release]") {
+  cache::trim();
+  {
+    recycling_indirect_value<Buffer> v(std::in_place, 100);
+    REQUIRE(Buffer::live == 1);
+  }
+  REQUIRE(cache::size() == 1);
+  REQUIRE(Buffer::live == 1);
+  cache::trim();
+  REQUIRE(cache::size() == 0);
+  REQUIRE(Buffer::live == 0);
+}
+
+TEST_CASE("Copies reuse a retained pointee and its capacity",
+          "[recycling_copy.copy]") {
+  cache::trim();
+  const recycling_indirect_value<Buffer> source(std::in_place, 100);
+  const Buffer* retained = nullptr;
+  {
+    recycling_indirect_value<Buffer> v(std::in_place, 1000);
+    retained = &*v;
+  }
+  REQUIRE(cache::size() == 1);
+
+  GIVEN("A copy made while the cache holds an object") {
+    recycling_indirect_value<Buffer> copy = source;
+    THEN("The retained object is copy-assigned instead of allocating") {
+      REQUIRE(&*copy == retained);
+      REQUIRE(copy->data.size() == 100);
+      REQUIRE(copy->data.capacity() >= 1000);
+      REQUIRE(cache::size() == 0);
+    }
+  }
+  GIVEN("A warm cache") {
+    THEN("Copying and destroying a value does not allocate") {
+      const auto counts = count_allocations([&] {
+        for (int i = 0; i < 10; ++i) {
+          recycling_indirect_value<Buffer> copy = source;
+        }
+      });
+      REQUIRE(counts.allocations == 0);
+      REQUIRE(counts.deallocations == 0);
+    }
+  }
+  cache::trim();
+}
+
+TEST_CASE("The recycling cache is bounded", "[recycling_copy.limit]") {
+  cache::trim();
+  const auto previous_limit = cache::limit();
+  cache::set_limit(2);
+  {
+    std::vector<recycling_indirect_value<Buffer>> values;
+    for (int i = 0; i < 5; ++i) values.emplace_back(std::in_place, 10);
+  }
+  REQUIRE(cache::size() == 2);
+  REQUIRE(Buffer::live == 2);
+
+  WHEN("The limit is lowered") {
+    cache::set_limit(1);
+    THEN("Surplus objects are destroyed") {
+      REQUIRE(cache::size() == 1);
+      REQUIRE(Buffer::live == 1);
+    }
+  }
+  WHEN("The limit is zero") {
+    cache::set_limit(0);
+    THEN("Nothing is retained") {
+      { recycling_indirect_value<Buffer> v(std::in_place, 10); }
+      REQUIRE(cache::size() == 0);
+      REQUIRE(Buffer::live == 0);
+    }
+  }
+  cache::set_limit(previous_limit);
+  cache::trim();
+}
+
+TEST_CASE("Each thread has its own recycling cache",
+          "[recycling_copy.thread]") {
+  cache::trim();
+  { recycling_indirect_value<Buffer> v(std::in_place, 10); }
+  REQUIRE(cache::size() == 1);
+
+  std::size_t other_thread_size = 1;
+  std::thread([&] {
+    other_thread_size = cache::size();
+    recycling_indirect_value<Buffer> v(std::in_place, 10);
+  }).join();
+  THEN("The other thread's cache was destroyed with the thread") {
+    REQUIRE(other_thread_size == 0);
+    REQUIRE(cache::size() == 1);
+    REQUIRE(Buffer::live == 1);
+  }
+  cache::trim();
+}
+
+TEST_CASE("Values released after the thread's cache is destroyed are deleted",
+          "[recycling_copy.thread_exit]") {
+  cache::trim();
+  const int live = Buffer::live;
+  std::thread([] {
+    // Constructed before the cache, so destroyed after it at thread exit.
+    thread_local recycling_indirect_value<Buffer> outlives_cache(
+        std::in_place, 10);
+    { recycling_indirect_value<Buffer> v(std::in_place, 10); }
+    (void)outlives_cache;
+  }).join();
+  REQUIRE(Buffer::live == live);
+}
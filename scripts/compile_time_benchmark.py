@@ -0,0 +1,168 @@
+#!/usr/bin/env python
+"""Measures the compile-time cost of indirect_value's comparison operators.
+
+Generates a translation unit with N comparisons between indirect_values and
+between indirect_values and plain values, spread over many distinct value
+types so that each comparison needs fresh overload resolution, and times the
+compiler frontend (-fsyntax-only) on it for each operator path:
+
+  c++17           the SFINAE-constrained overload set, compiled as C++17.
+  c++20 sfinae    the same overload set under C++20, selected with
+                  ISOCPP_P1950_SFINAE_COMPARISONS.
+  c++20 concepts  the requires-constrained operator== and operator<=>, with
+                  the other operators synthesized by the compiler.
+
+Each configuration is compiled --repeat times and the fastest run reported.
+Parsing the headers is a fixed cost, so with more than one N the marginal
+cost per comparison between the smallest and largest N is reported as well.
+
+Usage: compile_time_benchmark.py [--cxx clang++] [-n 1000 4000] [--repeat 3]
+"""
+import argparse
+import os
+import subprocess
+import sys
+import tempfile
+import time
+
+REPO = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+MODES = [
+    ("c++17", ["-std=c++17"]),
+    ("c++20 sfinae", ["-std=c++20", "-DISOCPP_P1950_SFINAE_COMPARISONS"]),
+    ("c++20 concepts", ["-std=c++20"]),
+]
+
+# The comparisons cycled through; `a` and `b` are indirect_values and `v` is
+# a plain value of the same type.
+EXPRESSIONS = [
+    "a == b",
+    "a != b",
+    "a < b",
+    "a >= b",
+    "a == v",
+    "v != a",
+    "a < v",
+    "v <= a",
+    "a > v",
+    "a == nullptr",
+]
+
+FUNCTION_SIZE = 50
+
+
+def generate(n, types):
+    lines = [
+        '#include "indirect_value.h"',
+        "",
+        "using isocpp_p1950::indirect_value;",
+        "",
+        "template <int I>",
+        "struct key {",
+        "  int v;",
+        "  friend bool operator==(const key& l, const key& r) {",
+        "    return l.v == r.v;",
+        "  }",
+        "  friend bool operator!=(const key& l, const key& r) {",
+        "    return l.v != r.v;",
+        "  }",
+        "  friend bool operator<(const key& l, const key& r) {",
+        "    return l.v < r.v;",
+        "  }",
+        "  friend bool operator>(const key& l, const key& r) {",
+        "    return l.v > r.v;",
+        "  }",
+        "  friend bool operator<=(const key& l, const key& r) {",
+        "    return l.v <= r.v;",
+        "  }",
+        "  friend bool operator>=(const key& l, const key& r) {",
+        "    return l.v >= r.v;",
+        "  }",
+        "#if __cplusplus > 201703L",
+        "  friend auto operator<=>(const key& l, const key& r) {",
+        "    return l.v <=> r.v;",
+        "  }",
+        "#endif",
+        "};",
+        "",
+    ]
+    for f in range(0, n, FUNCTION_SIZE):
+        lines.append("int comparisons_%d() {" % (f // FUNCTION_SIZE))
+        lines.append("  int n = 0;")
+        for i in range(f, min(n, f + FUNCTION_SIZE)):
+            t = "key<%d>" % (i % types)
+            expr = EXPRESSIONS[i % len(EXPRESSIONS)]
+            lines.append("  {")
+            lines.append("    indirect_value<%s> a, b;" % t)
+            lines.append("    %s v{%d};" % (t, i))
+            lines.append("    (void)v;")
+            lines.append("    n += (%s);" % expr)
+            lines.append("  }")
+        lines.append("  return n;")
+        lines.append("}")
+        lines.append("")
+    return "\n".join(lines)
+
+
+def time_compile(cxx, flags, source, repeat):
+    cmd = [cxx, "-fsyntax-only", "-I", REPO] + flags + [source]
+    best = None
+    for _ in range(repeat):
+        start = time.perf_counter()
+        result = subprocess.run(cmd, stdout=subprocess.PIPE,
+                                stderr=subprocess.PIPE, universal_newlines=True)
+        elapsed = time.perf_counter() - start
+        if result.returncode != 0:
+            sys.stderr.write(" ".join(cmd) + "\n" + result.stderr)
+            return None
+        best = elapsed if best is None else min(best, elapsed)
+    return best
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--cxx", default=os.environ.get("CXX", "c++"),
+                        help="compiler to run (default: $CXX or c++)")
+    parser.add_argument("-n", type=int, nargs="+", default=[1000, 4000],
+                        help="numbers of comparisons to generate")
+    parser.add_argument("--types", type=int, default=100,
+                        help="number of distinct value types")
+    parser.add_argument("--repeat", type=int, default=3,
+                        help="compilations per configuration")
+    parser.add_argument("--keep", action="store_true",
+                        help="keep the generated sources")
+    args = parser.parse_args()
+
+    print("%-8s %-16s %10s" % ("N", "path", "seconds"))
+    directory = tempfile.mkdtemp(prefix="indirect_value_compile_time_")
+    results = {}
+    for n in args.n:
+        source = os.path.join(directory, "comparisons_%d.cpp" % n)
+        with open(source, "w") as f:
+            f.write(generate(n, args.types))
+        for name, flags in MODES:
+            seconds = time_compile(args.cxx, flags, source, args.repeat)
+            results[(n, name)] = seconds
+            shown = "failed" if seconds is None else "%.3f" % seconds
+            print("%-8d %-16s %10s" % (n, name, shown))
+            sys.stdout.flush()
+        if not args.keep:
+            os.remove(source)
+    if args.keep:
+        print("sources kept in %s" % directory)
+    else:
+        os.rmdir(directory)
+
+    low, high = min(args.n), max(args.n)
+    if low != high:
+        print("\nmarginal cost from N=%d to N=%d" % (low, high))
+        for name, _ in MODES:
+            first, last = results[(low, name)], results[(high, name)]
+            if first is None or last is None:
+                continue
+            per = (last - first) / (high - low) * 1e6
+            print("%-16s %10.1f us/comparison" % (name, per))
+
+
+if __name__ == "__main__":
+    main()